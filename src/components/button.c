@@ -18,9 +18,11 @@
 #include <gtk-4.0/gtk/gtk.h>
 #include "config/config.h"
 #include "button.h"
+#include "../koto-art-cache.h"
 #include "../koto-window.h"
 #include "../koto-utils.h"
 
+extern KotoArtCache * koto_art_cache;
 extern KotoWindow * main_window;
 
 struct _PixbufSize {
@@ -706,12 +708,13 @@ void koto_button_show_image(
 			return;
 		}
 
-		if (GTK_IS_IMAGE(self->button_pic)) { // Already have an icon
-			gtk_image_set_from_file(GTK_IMAGE(self->button_pic), self->image_file_path);
-		} else { // Don't have an image yet
-			self->button_pic = gtk_image_new_from_file(self->image_file_path); // Create a new image from the file
+		if (!GTK_IS_IMAGE(self->button_pic)) { // Don't have an image yet
+			self->button_pic = gtk_image_new();
+			gtk_image_set_pixel_size(GTK_IMAGE(self->button_pic), self->pix_size);
 			gtk_box_prepend(GTK_BOX(self), self->button_pic); // Prepend to the box
 		}
+
+		koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(self->button_pic), self->image_file_path, self->pix_size, self->pix_size, NULL); // Decoded at our pixbuf size off the main thread
 	} else { // From icon name
 		if (use_alt && ((self->alt_icon_name == NULL) || (strcmp(self->alt_icon_name, "") == 0))) { // Don't have an alt icon set
 			return;
@@ -17,10 +17,13 @@
 
 #include <glib-2.0/glib.h>
 #include <gtk-4.0/gtk/gtk.h>
+#include "../koto-art-cache.h"
 #include "../koto-utils.h"
 #include "button.h"
 #include "cover-art-button.h"
 
+extern KotoArtCache * koto_art_cache;
+
 struct _KotoCoverArtButton {
 	GObject parent_instance;
 
@@ -202,15 +205,19 @@ void koto_cover_art_button_set_art_path(
 
 	if (GTK_IS_IMAGE(self->art)) { // Already have an image
 		if (!defined_artwork) { // No art path or empty string
-			gtk_image_set_from_icon_name(GTK_IMAGE(self->art), "audio-x-generic-symbolic");
+			g_free(self->art_path);
+			self->art_path = NULL;
+			koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(self->art), NULL, self->width, self->height, "audio-x-generic-symbolic");
 		} else { // Have an art path
 			if (g_strcmp0(self->art_path, art_path) != 0) {
+				g_free(self->art_path);
 				self->art_path = g_strdup(art_path); // Set our art path
-				gtk_image_set_from_file(GTK_IMAGE(self->art), self->art_path); // Set from the file
+				koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(self->art), self->art_path, self->width, self->height, "audio-x-generic-symbolic"); // Swapped in once decoded at our size
 			}
 		}
 	} else { // If we don't have an image
-		self->art = koto_utils_create_image_from_filepath(defined_artwork ? g_strdup(art_path) : NULL, "audio-x-generic-symbolic", self->width, self->height);
+		self->art_path = defined_artwork ? g_strdup(art_path) : NULL;
+		self->art = koto_utils_create_image_from_filepath(self->art_path, "audio-x-generic-symbolic", self->width, self->height);
 		gtk_overlay_set_child(GTK_OVERLAY(self->main), self->art); // Set the child
 	}
 }
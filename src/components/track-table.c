@@ -103,6 +103,45 @@ static void koto_track_table_init(KotoTrackTable * self) {
 	g_signal_connect(action_bar, "closed", G_CALLBACK(koto_track_table_handle_action_bar_closed), self); // Handle closed action bar
 }
 
+static void koto_track_table_bind_playlist(KotoTrackTable * self) {
+	if (self->model == G_LIST_MODEL(self->playlist)) { // Already showing this playlist, which emits precise changes as tracks are added, removed or sorted
+		return;
+	}
+
+	self->model = G_LIST_MODEL(self->playlist); // Our playlist is our model
+
+	g_clear_object(&self->selection_model);
+	self->selection_model = GTK_SELECTION_MODEL(gtk_multi_selection_new(g_object_ref(self->model))); // Selection takes ownership of the model it is given
+	g_signal_connect(self->selection_model, "selection-changed", G_CALLBACK(koto_track_table_handle_tracks_selected), self); // Bind to our selection changed
+
+	gtk_list_view_set_model(GTK_LIST_VIEW(self->track_list_view), self->selection_model); // Set our multi selection model to our provided model
+}
+
+static void koto_track_table_handle_item_position_changed(
+	GtkListItem * item,
+	GParamSpec * pspec,
+	gpointer user_data
+) {
+	(void) pspec;
+	(void) user_data;
+
+	GtkWidget * box = gtk_list_item_get_child(item);
+
+	if (!GTK_IS_WIDGET(box)) { // No content yet
+		return;
+	}
+
+	guint position = gtk_list_item_get_position(item);
+
+	if (position == GTK_INVALID_LIST_POSITION) { // Not bound to an item
+		return;
+	}
+
+	gchar * position_str = g_strdup_printf("%u", position + 1);
+	gtk_label_set_label(GTK_LABEL(gtk_widget_get_first_child(box)), position_str); // Rows after an insert or removal move without being rebound, so keep our number in sync
+	g_free(position_str);
+}
+
 void koto_track_table_bind_track_item(
 	GtkListItemFactory * factory,
 	GtkListItem * item,
@@ -135,9 +174,7 @@ void koto_track_table_bind_track_item(
 		NULL
 	);
 
-	guint track_position = koto_playlist_get_position_of_track(self->playlist, track) + 1;
-
-	gtk_label_set_label(GTK_LABEL(track_position_label), g_strdup_printf("%u", track_position)); // Set the track position
+	koto_track_table_handle_item_position_changed(item, NULL, self); // Set the track position, which matches our place in the playlist
 	gtk_label_set_label(GTK_LABEL(track_name_label), track_name); // Set our track name
 
 	if (koto_utils_string_is_valid(album_uuid)) { // Is associated with an album
@@ -391,8 +428,7 @@ void koto_track_table_set_model(
 		return;
 	}
 
-	koto_playlist_apply_model(self->playlist, model); // Apply our new model
-	self->model = G_LIST_MODEL(koto_playlist_get_store(self->playlist)); // Get the latest generated model / store and cast it as a GListModel
+	koto_playlist_apply_model(self->playlist, model); // Apply our new model, which the playlist reports to our view itself
 
 	if (model != KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ALBUM) { // Not sorting by album currently
 		gtk_widget_remove_css_class(GTK_WIDGET(self->track_album_button), "active");
@@ -406,10 +442,7 @@ void koto_track_table_set_model(
 		gtk_widget_remove_css_class(GTK_WIDGET(self->track_title_button), "active");
 	}
 
-	self->selection_model = GTK_SELECTION_MODEL(gtk_multi_selection_new(self->model));
-	g_signal_connect(self->selection_model, "selection-changed", G_CALLBACK(koto_track_table_handle_tracks_selected), self); // Bind to our selection changed
-
-	gtk_list_view_set_model(GTK_LIST_VIEW(self->track_list_view), self->selection_model); // Set our multi selection model to our provided model
+	koto_track_table_bind_playlist(self);
 }
 
 void koto_track_table_set_playlist_model (
@@ -424,8 +457,7 @@ void koto_track_table_set_playlist_model (
 		return;
 	}
 
-	koto_playlist_apply_model(self->playlist, model); // Apply our new model
-	self->model = G_LIST_MODEL(koto_playlist_get_store(self->playlist)); // Get the latest generated model / store and cast it as a GListModel
+	koto_playlist_apply_model(self->playlist, model); // Apply our new model, which the playlist reports to our view itself
 
 	if (model != KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ALBUM) { // Not sorting by album currently
 		gtk_widget_remove_css_class(GTK_WIDGET(self->track_album_button), "active");
@@ -439,10 +471,7 @@ void koto_track_table_set_playlist_model (
 		gtk_widget_remove_css_class(GTK_WIDGET(self->track_title_button), "active");
 	}
 
-	self->selection_model = GTK_SELECTION_MODEL(gtk_multi_selection_new(self->model));
-	g_signal_connect(self->selection_model, "selection-changed", G_CALLBACK(koto_track_table_handle_tracks_selected), self); // Bind to our selection changed
-
-	gtk_list_view_set_model(GTK_LIST_VIEW(self->track_list_view), self->selection_model); // Set our multi selection model to our provided model
+	koto_track_table_bind_playlist(self);
 
 	KotoPreferredPlaylistSortType current_model = koto_playlist_get_current_model(self->playlist); // Get the current model
 
@@ -526,6 +555,7 @@ void koto_track_table_setup_track_item(
 	gtk_size_group_add_widget(self->track_artist_size_group, track_artist);
 
 	gtk_list_item_set_child(item, item_content);
+	g_signal_connect(item, "notify::position", G_CALLBACK(koto_track_table_handle_item_position_changed), self);
 
 	GtkGesture * double_click_gesture = gtk_gesture_click_new(); // Create our new GtkGesture for double-click handling
 	gtk_widget_add_controller(item_content, GTK_EVENT_CONTROLLER(double_click_gesture)); // Have our item handle double clicking
@@ -34,6 +34,8 @@ extern KotoPlaybackEngine * playback_engine;
 
 enum {
 	PROP_0,
+	PROP_INDEXER_BATCH_SIZE,
+	PROP_INDEXER_WORKERS,
 	PROP_PLAYBACK_CONTINUE_ON_PLAYLIST,
 	PROP_PLAYBACK_LAST_USED_VOLUME,
 	PROP_PLAYBACK_MAINTAIN_SHUFFLE,
@@ -70,6 +72,11 @@ struct _KotoConfig {
 	gboolean has_type_music;
 	gboolean has_type_podcast;
 
+	/* Indexer Settings */
+
+	guint indexer_batch_size;
+	guint indexer_workers;
+
 	/* Playback Settings */
 
 	gboolean playback_continue_on_playlist;
@@ -124,6 +131,26 @@ static void koto_config_class_init(KotoConfigClass * c) {
 	gobject_class->get_property = koto_config_get_property;
 	gobject_class->set_property = koto_config_set_property;
 
+	config_props[PROP_INDEXER_BATCH_SIZE] = g_param_spec_uint(
+		"indexer-batch-size",
+		"Indexer Batch Size",
+		"Number of database writes grouped into each transaction during indexing. 1 commits every write on its own",
+		1,
+		100000,
+		1000,
+		G_PARAM_CONSTRUCT | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READWRITE
+	);
+
+	config_props[PROP_INDEXER_WORKERS] = g_param_spec_uint(
+		"indexer-workers",
+		"Indexer Workers",
+		"Number of workers probing and parsing files during indexing. 0 uses one per processor, 1 indexes serially",
+		0,
+		64,
+		0, // One per processor
+		G_PARAM_CONSTRUCT | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_READWRITE
+	);
+
 	config_props[PROP_PLAYBACK_CONTINUE_ON_PLAYLIST] = g_param_spec_boolean(
 		"playback-continue-on-playlist",
 		"Continue Playback of Playlist",
@@ -250,6 +277,12 @@ static void koto_config_get_property(
 	KotoConfig * self = KOTO_CONFIG(obj);
 
 	switch (prop_id) {
+		case PROP_INDEXER_BATCH_SIZE:
+			g_value_set_uint(val, self->indexer_batch_size);
+			break;
+		case PROP_INDEXER_WORKERS:
+			g_value_set_uint(val, self->indexer_workers);
+			break;
 		case PROP_PLAYBACK_CONTINUE_ON_PLAYLIST:
 			g_value_set_boolean(val, self->playback_continue_on_playlist);
 			break;
@@ -298,6 +331,12 @@ static void koto_config_set_property(
 	KotoConfig * self = KOTO_CONFIG(obj);
 
 	switch (prop_id) {
+		case PROP_INDEXER_BATCH_SIZE:
+			self->indexer_batch_size = g_value_get_uint(val);
+			break;
+		case PROP_INDEXER_WORKERS:
+			self->indexer_workers = g_value_get_uint(val);
+			break;
 		case PROP_PLAYBACK_CONTINUE_ON_PLAYLIST:
 			self->playback_continue_on_playlist = g_value_get_boolean(val);
 			break;
@@ -464,6 +503,23 @@ void koto_config_load(
 		}
 	}
 
+	/** Indexer Section */
+
+	toml_table_t * indexer_section = toml_table_in(conf, "indexer");
+
+	if (indexer_section) { // Have indexer section
+		toml_datum_t batch_size = toml_int_in(indexer_section, "batch-size");
+		toml_datum_t workers = toml_int_in(indexer_section, "workers");
+
+		if (batch_size.ok && (batch_size.u.i >= 1) && (self->indexer_batch_size != batch_size.u.i)) { // If we have a batch size set and it is different
+			g_object_set(self, "indexer-batch-size", (guint) batch_size.u.i, NULL);
+		}
+
+		if (workers.ok && (workers.u.i >= 0) && (self->indexer_workers != workers.u.i)) { // If we have workers set and it is different
+			g_object_set(self, "indexer-workers", (guint) workers.u.i, NULL);
+		}
+	}
+
 	/** Playback Section */
 
 	toml_table_t * playback_section = toml_table_in(conf, "playback");
@@ -570,6 +626,7 @@ void koto_config_load_libs(KotoConfig * self) {
 			koto_cartographer_add_library(koto_maps, lib);
 			koto_config_save(config);
 			koto_library_index(lib); // Index this library
+			koto_library_watch(lib); // Watch for changes so we never need a full rescan
 		}
 
 		g_free(audiobooks_path);
@@ -582,6 +639,7 @@ void koto_config_load_libs(KotoConfig * self) {
 			koto_cartographer_add_library(koto_maps, lib);
 			koto_config_save(config);
 			koto_library_index(lib); // Index this library
+			koto_library_watch(lib); // Watch for changes so we never need a full rescan
 		}
 	}
 
@@ -594,6 +652,7 @@ void koto_config_load_libs(KotoConfig * self) {
 			koto_cartographer_add_library(koto_maps, lib);
 			koto_config_save(config);
 			koto_library_index(lib); // Index this library
+			koto_library_watch(lib); // Watch for changes so we never need a full rescan
 		}
 
 		g_free(podcasts_path);
@@ -603,6 +662,19 @@ void koto_config_load_libs(KotoConfig * self) {
 	g_thread_exit(0);
 }
 
+void koto_config_reconcile_libs(KotoConfig * self) {
+	(void) self;
+
+	GList * libs = koto_cartographer_get_libraries(koto_maps); // Get all of our libraries
+	GList * current_libs;
+
+	for (current_libs = libs; current_libs != NULL; current_libs = current_libs->next) { // For each library
+		koto_library_reconcile(current_libs->data); // Pick up anything that changed while we were closed, then watch it
+	}
+
+	g_list_free(libs);
+}
+
 void koto_config_monitor_handle_changed(
 	GFileMonitor * monitor,
 	GFile * file,
@@ -623,6 +695,18 @@ void koto_config_monitor_handle_changed(
 	}
 }
 
+guint koto_config_get_indexer_batch_size(KotoConfig * self) {
+	return self->indexer_batch_size;
+}
+
+guint koto_config_get_indexer_workers(KotoConfig * self) {
+	if (self->indexer_workers == 0) { // Automatic
+		return g_get_num_processors(); // One worker per processor
+	}
+
+	return self->indexer_workers;
+}
+
 KotoPreferredAlbumSortType koto_config_get_preferred_album_sort_type(KotoConfig * self) {
 	return self->preferred_album_sort_type;
 }
@@ -658,6 +742,7 @@ void koto_config_save(KotoConfig * self) {
 
 	/* Section Hashes*/
 
+	gchar * indexer_hash = g_strdup("indexer");
 	gchar * playback_hash = g_strdup("playback");
 	gchar * ui_hash = g_strdup("ui");
 
@@ -681,7 +766,9 @@ void koto_config_save(KotoConfig * self) {
 
 		gpointer respective_prop = NULL;
 
-		if (g_str_has_prefix(prop_name, "playback")) { // Is playback
+		if (g_str_has_prefix(prop_name, "indexer")) { // Is indexer
+			respective_prop = indexer_hash;
+		} else if (g_str_has_prefix(prop_name, "playback")) { // Is playback
 			respective_prop = playback_hash;
 		} else if (g_str_has_prefix(prop_name, "ui")) { // Is UI
 			respective_prop = ui_hash;
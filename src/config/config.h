@@ -38,6 +38,8 @@ void koto_config_load(
 
 void koto_config_load_libs(KotoConfig * self);
 
+void koto_config_reconcile_libs(KotoConfig * self);
+
 void koto_config_monitor_handle_changed(
 	GFileMonitor * monitor,
 	GFile * file,
@@ -46,6 +48,10 @@ void koto_config_monitor_handle_changed(
 	gpointer user_data
 );
 
+guint koto_config_get_indexer_batch_size(KotoConfig * self);
+
+guint koto_config_get_indexer_workers(KotoConfig * self);
+
 KotoPreferredAlbumSortType koto_config_get_preferred_album_sort_type(KotoConfig * self);
 
 void koto_config_refresh(KotoConfig * self);
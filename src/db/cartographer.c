@@ -19,6 +19,8 @@
 #include "../koto-utils.h"
 #include "cartographer.h"
 
+#define KOTO_CARTOGRAPHER_CHANGES_INTERVAL_MS 50
+
 enum {
 	SIGNAL_ALBUM_ADDED,
 	SIGNAL_ALBUM_REMOVED,
@@ -30,9 +32,30 @@ enum {
 	SIGNAL_PLAYLIST_REMOVED,
 	SIGNAL_TRACK_ADDED,
 	SIGNAL_TRACK_REMOVED,
+	SIGNAL_ARTISTS_ADDED,
+	SIGNAL_ALBUMS_ADDED,
+	SIGNAL_TRACKS_ADDED,
+	SIGNAL_ARTISTS_REMOVED,
+	SIGNAL_ALBUMS_REMOVED,
+	SIGNAL_TRACKS_REMOVED,
 	N_SIGNALS
 };
 
+typedef enum {
+	KOTO_CARTOGRAPHER_CHANGE_ARTISTS_ADDED,
+	KOTO_CARTOGRAPHER_CHANGE_ALBUMS_ADDED,
+	KOTO_CARTOGRAPHER_CHANGE_TRACKS_ADDED,
+	KOTO_CARTOGRAPHER_CHANGE_ARTISTS_REMOVED,
+	KOTO_CARTOGRAPHER_CHANGE_ALBUMS_REMOVED,
+	KOTO_CARTOGRAPHER_CHANGE_TRACKS_REMOVED,
+	KOTO_CARTOGRAPHER_CHANGE_COUNT
+} KotoCartographerChange;
+
+typedef struct {
+	GPtrArray * changes[KOTO_CARTOGRAPHER_CHANGE_COUNT]; // Changes of each kind, in the order of KotoCartographerChange
+	gboolean has_removals; // Whether anything was removed, after which additions go in the next batch
+} KotoCartographerChangeBatch;
+
 static guint cartographer_signals[N_SIGNALS] = {
 	0
 };
@@ -40,13 +63,20 @@ static guint cartographer_signals[N_SIGNALS] = {
 struct _KotoCartographer {
 	GObject parent_instance;
 
+	GRWLock lock; // Guards all of our tables, since the indexing and loading threads add to them while the UI reads
+
 	GHashTable * albums;
 	GHashTable * artists;
 	GHashTable * artists_name_to_uuid;
 	GHashTable * libraries;
 	GHashTable * playlists;
 	GHashTable * tracks;
-	GHashTable * tracks_by_uniqueish_key;
+	GHashTable * tracks_by_uniqueish_key; // Normalized artist, album and track name keys to their track
+	GHashTable * uniqueish_keys_by_track; // Track UUIDs to the key they are indexed under, so we can drop stale keys
+
+	GMutex changes_lock; // Guards our pending changes, which may be queued from any thread
+	GQueue * change_batches; // Pending KotoCartographerChangeBatches, delivered in the order they were queued
+	guint changes_source_id; // Timeout that delivers our pending changes on the main context
 };
 
 struct _KotoCartographerClass {
@@ -92,6 +122,30 @@ struct _KotoCartographerClass {
 		KotoCartographer * cartographer,
 		KotoTrack * track
 	);
+	void (* artists_added) (
+		KotoCartographer * cartographer,
+		GPtrArray * artists
+	);
+	void (* albums_added) (
+		KotoCartographer * cartographer,
+		GPtrArray * albums
+	);
+	void (* tracks_added) (
+		KotoCartographer * cartographer,
+		GPtrArray * tracks
+	);
+	void (* artists_removed) (
+		KotoCartographer * cartographer,
+		GPtrArray * artists
+	);
+	void (* albums_removed) (
+		KotoCartographer * cartographer,
+		GPtrArray * album_uuids
+	);
+	void (* tracks_removed) (
+		KotoCartographer * cartographer,
+		GPtrArray * track_uuids
+	);
 };
 
 G_DEFINE_TYPE(KotoCartographer, koto_cartographer, G_TYPE_OBJECT);
@@ -233,16 +287,306 @@ static void koto_cartographer_class_init(KotoCartographerClass * c) {
 		1,
 		G_TYPE_CHAR
 	);
+
+	cartographer_signals[SIGNAL_ARTISTS_ADDED] = g_signal_new(
+		"artists-added",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, artists_added),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
+	cartographer_signals[SIGNAL_ALBUMS_ADDED] = g_signal_new(
+		"albums-added",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, albums_added),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
+	cartographer_signals[SIGNAL_TRACKS_ADDED] = g_signal_new(
+		"tracks-added",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, tracks_added),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
+	cartographer_signals[SIGNAL_ARTISTS_REMOVED] = g_signal_new(
+		"artists-removed",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, artists_removed),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
+	cartographer_signals[SIGNAL_ALBUMS_REMOVED] = g_signal_new(
+		"albums-removed",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, albums_removed),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
+	cartographer_signals[SIGNAL_TRACKS_REMOVED] = g_signal_new(
+		"tracks-removed",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoCartographerClass, tracks_removed),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
 }
 
 static void koto_cartographer_init(KotoCartographer * self) {
+	g_rw_lock_init(&self->lock);
 	self->albums = g_hash_table_new(g_str_hash, g_str_equal);
 	self->artists = g_hash_table_new(g_str_hash, g_str_equal);
 	self->artists_name_to_uuid = g_hash_table_new(g_str_hash, g_str_equal);
 	self->libraries = g_hash_table_new(g_str_hash, g_str_equal);
 	self->playlists = g_hash_table_new(g_str_hash, g_str_equal);
 	self->tracks = g_hash_table_new(g_str_hash, g_str_equal);
-	self->tracks_by_uniqueish_key = g_hash_table_new(g_str_hash, g_str_equal);
+	self->tracks_by_uniqueish_key = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->uniqueish_keys_by_track = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+	g_mutex_init(&self->changes_lock);
+	self->change_batches = g_queue_new();
+	self->changes_source_id = 0;
+}
+
+static gboolean koto_cartographer_emit_changes(gpointer user_data) {
+	KotoCartographer * self = user_data;
+
+	g_mutex_lock(&self->changes_lock);
+	GQueue * batches = self->change_batches; // Take everything pending, so changes queued while we emit go in the next delivery
+	self->change_batches = g_queue_new();
+	self->changes_source_id = 0;
+	g_mutex_unlock(&self->changes_lock);
+
+	KotoCartographerChangeBatch * batch;
+
+	while ((batch = g_queue_pop_head(batches)) != NULL) { // For each batch, in the order they were queued
+		for (guint i = 0; i < KOTO_CARTOGRAPHER_CHANGE_COUNT; i++) { // For each kind of change, additions first so artists exist before their albums and tracks
+			if (batch->changes[i] == NULL) { // Nothing of this kind
+				continue;
+			}
+
+			g_signal_emit(
+				self,
+				cartographer_signals[SIGNAL_ARTISTS_ADDED + i],
+				0,
+				batch->changes[i]
+			);
+
+			g_ptr_array_unref(batch->changes[i]);
+		}
+
+		g_free(batch);
+	}
+
+	g_queue_free(batches);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * Queue a change for the batched change signals, taking ownership of the item.
+ * Changes from any thread are delivered together on the main context, so UI can update once per batch rather than once per object.
+ * Each batch emits its additions before its removals, so an addition queued after a removal starts a new batch. Otherwise an artist removed and added back within one delivery would be added while the old one is still around, then removed.
+ **/
+static void koto_cartographer_queue_change(
+	KotoCartographer * self,
+	KotoCartographerChange change,
+	gpointer item
+) {
+	gboolean is_removal = change >= KOTO_CARTOGRAPHER_CHANGE_ARTISTS_REMOVED;
+
+	g_mutex_lock(&self->changes_lock);
+
+	KotoCartographerChangeBatch * batch = g_queue_peek_tail(self->change_batches);
+
+	if ((batch == NULL) || (!is_removal && batch->has_removals)) { // No batch yet, or this addition must come after the removals already queued
+		batch = g_new0(KotoCartographerChangeBatch, 1);
+		g_queue_push_tail(self->change_batches, batch);
+	}
+
+	if (batch->changes[change] == NULL) { // First change of this kind in this batch
+		gboolean is_uuid = (change == KOTO_CARTOGRAPHER_CHANGE_ALBUMS_REMOVED) || (change == KOTO_CARTOGRAPHER_CHANGE_TRACKS_REMOVED);
+		batch->changes[change] = g_ptr_array_new_with_free_func(is_uuid ? g_free : g_object_unref);
+	}
+
+	g_ptr_array_add(batch->changes[change], item);
+	batch->has_removals = batch->has_removals || is_removal;
+
+	if (self->changes_source_id == 0) { // No delivery scheduled yet
+		self->changes_source_id = g_timeout_add(KOTO_CARTOGRAPHER_CHANGES_INTERVAL_MS, koto_cartographer_emit_changes, self); // Attaches to the default main context, regardless of our thread
+	}
+
+	g_mutex_unlock(&self->changes_lock);
+}
+
+static gchar * koto_cartographer_normalize_key_part(const gchar * part) {
+	if (!koto_utils_string_is_valid(part)) { // Nothing to normalize
+		return g_strdup("");
+	}
+
+	gchar * normalized = g_utf8_normalize(part, -1, G_NORMALIZE_ALL); // Fold compatibility forms and combining characters
+
+	if (normalized == NULL) { // Not valid UTF-8
+		normalized = g_utf8_make_valid(part, -1);
+	}
+
+	gchar * folded = g_utf8_casefold(normalized, -1); // Ignore case differences between tags and folder names
+	g_free(normalized);
+
+	return g_strstrip(folded);
+}
+
+/**
+ * Build the key used to find an existing track for an artist, optional album and track name, so rescans update tracks instead of creating new ones.
+ **/
+gchar * koto_cartographer_build_uniqueish_key(
+	const gchar * artist_name,
+	const gchar * album_name,
+	const gchar * track_name
+) {
+	if (!koto_utils_string_is_valid(track_name)) { // Can't identify a track without its name
+		return NULL;
+	}
+
+	gchar * artist_part = koto_cartographer_normalize_key_part(artist_name);
+	gchar * album_part = koto_cartographer_normalize_key_part(album_name);
+	gchar * track_part = koto_cartographer_normalize_key_part(track_name);
+	gchar * key = g_strdup_printf("%s\x1f%s\x1f%s", artist_part, album_part, track_part); // Separate with a unit separator since names commonly contain dashes
+
+	g_free(artist_part);
+	g_free(album_part);
+	g_free(track_part);
+
+	return key;
+}
+
+static void koto_cartographer_unindex_track(
+	KotoCartographer * self,
+	KotoTrack * track
+) {
+	gchar * track_uuid = koto_track_get_uuid(track);
+	gchar * key = g_hash_table_lookup(self->uniqueish_keys_by_track, track_uuid);
+
+	if (key == NULL) { // Not indexed
+		return;
+	}
+
+	if (g_hash_table_lookup(self->tracks_by_uniqueish_key, key) == track) { // Key has not since been taken by another track
+		g_hash_table_remove(self->tracks_by_uniqueish_key, key);
+	}
+
+	g_hash_table_remove(self->uniqueish_keys_by_track, track_uuid); // Frees our key
+}
+
+/**
+ * Index a track under the key from koto_track_get_uniqueish_key, taking ownership of the key.
+ * Must be called with the write lock held, while the key itself must be built without it since that looks up the artist and album.
+ **/
+static void koto_cartographer_index_track(
+	KotoCartographer * self,
+	KotoTrack * track,
+	gchar * key
+) {
+	koto_cartographer_unindex_track(self, track); // Drop any key from before a rename
+
+	if (!koto_utils_string_is_valid(key)) { // No key for this track
+		g_free(key);
+		return;
+	}
+
+	g_hash_table_replace(self->uniqueish_keys_by_track, koto_track_get_uuid(track), g_strdup(key));
+	g_hash_table_replace(self->tracks_by_uniqueish_key, key, track); // Table takes ownership of the key
+}
+
+static void koto_cartographer_reindex_track(
+	KotoCartographer * self,
+	KotoTrack * track
+) {
+	gchar * key = koto_track_get_uniqueish_key(track);
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_lookup(self->tracks, koto_track_get_uuid(track)) == track) { // Track is one of ours
+		koto_cartographer_index_track(self, track, key);
+	} else {
+		g_free(key);
+	}
+
+	g_rw_lock_writer_unlock(&self->lock);
+}
+
+static void koto_cartographer_handle_track_key_changed(
+	KotoTrack * track,
+	GParamSpec * pspec,
+	KotoCartographer * self
+) {
+	(void) pspec;
+	koto_cartographer_reindex_track(self, track);
+}
+
+static void koto_cartographer_handle_album_name_changed(
+	KotoAlbum * album,
+	GParamSpec * pspec,
+	KotoCartographer * self
+) {
+	(void) pspec;
+
+	KotoPlaylist * playlist = koto_album_get_playlist(album);
+
+	if (!KOTO_IS_PLAYLIST(playlist)) { // No tracks to re-key
+		return;
+	}
+
+	for (guint i = 0; i < g_list_model_get_n_items(G_LIST_MODEL(playlist)); i++) { // For each track in the album
+		KotoTrack * track = g_list_model_get_item(G_LIST_MODEL(playlist), i);
+		koto_cartographer_reindex_track(self, track);
+		g_object_unref(track);
+	}
+}
+
+static void koto_cartographer_handle_artist_name_changed(
+	KotoArtist * artist,
+	GParamSpec * pspec,
+	KotoCartographer * self
+) {
+	(void) pspec;
+
+	for (GList * cur_list = koto_artist_get_tracks(artist); cur_list != NULL; cur_list = cur_list->next) { // For each track by the artist
+		koto_cartographer_reindex_track(self, cur_list->data);
+	}
 }
 
 void koto_cartographer_add_album(
@@ -259,11 +603,21 @@ void koto_cartographer_add_album(
 
 	gchar * album_uuid = koto_album_get_uuid(album); // Get the album UUID
 
-	if (!koto_utils_string_is_valid(album_uuid) || koto_cartographer_has_album_by_uuid(self, album_uuid)) { // Have the album or invalid UUID
+	if (!koto_utils_string_is_valid(album_uuid)) { // Invalid UUID
+		return;
+	}
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_contains(self->albums, album_uuid)) { // Have the album
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
 	g_hash_table_replace(self->albums, album_uuid, album);
+	g_rw_lock_writer_unlock(&self->lock); // Never hold the lock while handlers run, they will likely call back into us
+
+	g_signal_connect(album, "notify::name", G_CALLBACK(koto_cartographer_handle_album_name_changed), self); // Keep the keys of its tracks up to date
 
 	g_signal_emit(
 		self,
@@ -271,6 +625,8 @@ void koto_cartographer_add_album(
 		0,
 		album
 	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_ALBUMS_ADDED, g_object_ref(album));
 }
 
 void koto_cartographer_add_artist(
@@ -287,12 +643,22 @@ void koto_cartographer_add_artist(
 
 	gchar * artist_uuid = koto_artist_get_uuid(artist);
 
-	if (!koto_utils_string_is_valid(artist_uuid) || koto_cartographer_has_artist_by_uuid(self, artist_uuid)) { // Have the artist or invalid UUID
+	if (!koto_utils_string_is_valid(artist_uuid)) { // Invalid UUID
+		return;
+	}
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_contains(self->artists, artist_uuid)) { // Have the artist
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
 	g_hash_table_replace(self->artists_name_to_uuid, koto_artist_get_name(artist), artist_uuid); // Add the UUID as a value with the key being the name of the artist
 	g_hash_table_replace(self->artists, artist_uuid, artist);
+	g_rw_lock_writer_unlock(&self->lock);
+
+	g_signal_connect(artist, "notify::name", G_CALLBACK(koto_cartographer_handle_artist_name_changed), self); // Keep the keys of its tracks up to date
 
 	g_signal_emit(
 		self,
@@ -300,6 +666,8 @@ void koto_cartographer_add_artist(
 		0,
 		artist
 	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_ARTISTS_ADDED, g_object_ref(artist));
 }
 
 void koto_cartographer_add_library(
@@ -316,11 +684,20 @@ void koto_cartographer_add_library(
 
 	gchar * library_uuid = koto_library_get_uuid(library);
 
-	if (!koto_utils_string_is_valid(library_uuid) || koto_cartographer_has_library_by_uuid(self, library_uuid)) { // Have the library or invalid UUID
+	if (!koto_utils_string_is_valid(library_uuid)) { // Invalid UUID
+		return;
+	}
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_contains(self->libraries, library_uuid)) { // Have the library
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
 	g_hash_table_replace(self->libraries, library_uuid, library); // Add the library
+	g_rw_lock_writer_unlock(&self->lock);
+
 	g_signal_emit(
 		// Emit our library added signal
 		self,
@@ -344,11 +721,19 @@ void koto_cartographer_add_playlist(
 
 	gchar * playlist_uuid = koto_playlist_get_uuid(playlist);
 
-	if (!koto_playlist_get_uuid(playlist) || koto_cartographer_has_playlist_by_uuid(self, playlist_uuid)) { // Have the playlist or invalid UUID
+	if (!koto_utils_string_is_valid(playlist_uuid)) { // Invalid UUID
+		return;
+	}
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_contains(self->playlists, playlist_uuid)) { // Have the playlist
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
 	g_hash_table_replace(self->playlists, playlist_uuid, playlist);
+	g_rw_lock_writer_unlock(&self->lock);
 
 	if (koto_playlist_get_is_finalized(playlist)) { // Already finalized
 		koto_cartographer_emit_playlist_added(playlist, self); // Emit playlist-added immediately
@@ -373,6 +758,24 @@ void koto_cartographer_emit_playlist_added(
 	);
 }
 
+static void koto_cartographer_emit_track_added(
+	KotoCartographer * self,
+	KotoTrack * track
+) {
+	g_signal_connect(track, "notify::parsed-name", G_CALLBACK(koto_cartographer_handle_track_key_changed), self); // Re-key on rename or moving between albums and artists
+	g_signal_connect(track, "notify::album-uuid", G_CALLBACK(koto_cartographer_handle_track_key_changed), self);
+	g_signal_connect(track, "notify::artist-uuid", G_CALLBACK(koto_cartographer_handle_track_key_changed), self);
+
+	g_signal_emit(
+		self,
+		cartographer_signals[SIGNAL_TRACK_ADDED],
+		0,
+		track
+	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_TRACKS_ADDED, g_object_ref(track));
+}
+
 void koto_cartographer_add_track(
 	KotoCartographer * self,
 	KotoTrack * track
@@ -391,14 +794,71 @@ void koto_cartographer_add_track(
 		return;
 	}
 
+	gchar * key = koto_track_get_uniqueish_key(track); // Build before locking since this looks up the artist and album
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	if (g_hash_table_contains(self->tracks, track_uuid)) { // Added by another thread in the meantime
+		g_rw_lock_writer_unlock(&self->lock);
+		g_free(key);
+		return;
+	}
+
 	g_hash_table_replace(self->tracks, track_uuid, track);
+	koto_cartographer_index_track(self, track, key);
+	g_rw_lock_writer_unlock(&self->lock);
 
-	g_signal_emit(
-		self,
-		cartographer_signals[SIGNAL_TRACK_ADDED],
-		0,
-		track
-	);
+	koto_cartographer_emit_track_added(self, track);
+}
+
+/**
+ * Add many tracks while only taking the write lock once, emitting track-added for each track that was not already added.
+ **/
+void koto_cartographer_add_tracks(
+	KotoCartographer * self,
+	GPtrArray * tracks
+) {
+	if (!KOTO_IS_CARTOGRAPHER(self)) {
+		return;
+	}
+
+	if ((tracks == NULL) || (tracks->len == 0)) { // Nothing to add
+		return;
+	}
+
+	gchar ** keys = g_new0(gchar*, tracks->len);
+
+	for (guint i = 0; i < tracks->len; i++) { // Build our keys before locking since this looks up artists and albums
+		KotoTrack * track = g_ptr_array_index(tracks, i);
+		keys[i] = KOTO_IS_TRACK(track) ? koto_track_get_uniqueish_key(track) : NULL;
+	}
+
+	GPtrArray * added = g_ptr_array_sized_new(tracks->len);
+
+	g_rw_lock_writer_lock(&self->lock);
+
+	for (guint i = 0; i < tracks->len; i++) { // For each track
+		KotoTrack * track = g_ptr_array_index(tracks, i);
+		gchar * track_uuid = KOTO_IS_TRACK(track) ? koto_track_get_uuid(track) : NULL;
+
+		if (!koto_utils_string_is_valid(track_uuid) || g_hash_table_contains(self->tracks, track_uuid)) { // Have the track or invalid UUID
+			g_free(keys[i]);
+			continue;
+		}
+
+		g_hash_table_replace(self->tracks, track_uuid, track);
+		koto_cartographer_index_track(self, track, keys[i]);
+		g_ptr_array_add(added, track);
+	}
+
+	g_rw_lock_writer_unlock(&self->lock);
+	g_free(keys); // Keys were either freed or are now owned by our index
+
+	for (guint i = 0; i < added->len; i++) { // For each track we actually added
+		koto_cartographer_emit_track_added(self, g_ptr_array_index(added, i));
+	}
+
+	g_ptr_array_unref(added);
 }
 
 KotoAlbum * koto_cartographer_get_album_by_uuid(
@@ -409,11 +869,27 @@ KotoAlbum * koto_cartographer_get_album_by_uuid(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->albums, album_uuid);
+	if (!koto_utils_string_is_valid(album_uuid)) {
+		return NULL;
+	}
+
+	g_rw_lock_reader_lock(&self->lock);
+	KotoAlbum * album = g_hash_table_lookup(self->albums, album_uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return album;
 }
 
-GHashTable * koto_cartographer_get_artists(KotoCartographer * self) {
-	return self->artists;
+GList * koto_cartographer_get_artists(KotoCartographer * self) {
+	if (!KOTO_IS_CARTOGRAPHER(self)) {
+		return NULL;
+	}
+
+	g_rw_lock_reader_lock(&self->lock);
+	GList * artists = g_hash_table_get_values(self->artists); // Snapshot, since the table may change once we unlock
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return artists;
 }
 
 KotoArtist * koto_cartographer_get_artist_by_name(
@@ -428,7 +904,18 @@ KotoArtist * koto_cartographer_get_artist_by_name(
 		return NULL;
 	}
 
-	return koto_cartographer_get_artist_by_uuid(self, g_hash_table_lookup(self->artists_name_to_uuid, artist_name));
+	KotoArtist * artist = NULL;
+
+	g_rw_lock_reader_lock(&self->lock);
+	gchar * artist_uuid = g_hash_table_lookup(self->artists_name_to_uuid, artist_name);
+
+	if (koto_utils_string_is_valid(artist_uuid)) { // Have an artist by this name
+		artist = g_hash_table_lookup(self->artists, artist_uuid);
+	}
+
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return artist;
 }
 
 KotoArtist * koto_cartographer_get_artist_by_uuid(
@@ -443,7 +930,11 @@ KotoArtist * koto_cartographer_get_artist_by_uuid(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->artists, artist_uuid);
+	g_rw_lock_reader_lock(&self->lock);
+	KotoArtist * artist = g_hash_table_lookup(self->artists, artist_uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return artist;
 }
 
 KotoLibrary * koto_cartographer_get_library_by_uuid(
@@ -458,7 +949,11 @@ KotoLibrary * koto_cartographer_get_library_by_uuid(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->libraries, library_uuid);
+	g_rw_lock_reader_lock(&self->lock);
+	KotoLibrary * library = g_hash_table_lookup(self->libraries, library_uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return library;
 }
 
 KotoLibrary * koto_cartographer_get_library_containing_path(
@@ -512,19 +1007,26 @@ GList * koto_cartographer_get_libraries_for_storage_uuid(
 }
 
 GList * koto_cartographer_get_libraries(KotoCartographer * self) {
-	GList * libraries = g_hash_table_get_values(self->libraries);
+	g_rw_lock_reader_lock(&self->lock);
+	GList * libraries = g_hash_table_get_values(self->libraries); // Snapshot, since the table may change once we unlock
+	g_rw_lock_reader_unlock(&self->lock);
 	// TODO: Implement priority mechanism
 	return libraries;
 }
 
-GHashTable * koto_cartographer_get_playlists(KotoCartographer * self) {
+GList * koto_cartographer_get_playlists(KotoCartographer * self) {
 	if (!KOTO_IS_CARTOGRAPHER(self)) {
 		return NULL;
 	}
 
-	return self->playlists;
+	g_rw_lock_reader_lock(&self->lock);
+	GList * playlists = g_hash_table_get_values(self->playlists); // Snapshot, since the table may change once we unlock
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return playlists;
 }
 
+
 KotoPlaylist * koto_cartographer_get_playlist_by_uuid(
 	KotoCartographer * self,
 	gchar * playlist_uuid
@@ -533,7 +1035,15 @@ KotoPlaylist * koto_cartographer_get_playlist_by_uuid(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->playlists, playlist_uuid);
+	if (!koto_utils_string_is_valid(playlist_uuid)) {
+		return NULL;
+	}
+
+	g_rw_lock_reader_lock(&self->lock);
+	KotoPlaylist * playlist = g_hash_table_lookup(self->playlists, playlist_uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return playlist;
 }
 
 KotoTrack * koto_cartographer_get_track_by_uuid(
@@ -548,7 +1058,11 @@ KotoTrack * koto_cartographer_get_track_by_uuid(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->tracks, track_uuid);
+	g_rw_lock_reader_lock(&self->lock);
+	KotoTrack * track = g_hash_table_lookup(self->tracks, track_uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return track;
 }
 
 KotoTrack * koto_cartographer_get_track_by_uniqueish_key(
@@ -563,7 +1077,23 @@ KotoTrack * koto_cartographer_get_track_by_uniqueish_key(
 		return NULL;
 	}
 
-	return g_hash_table_lookup(self->tracks_by_uniqueish_key, key);
+	g_rw_lock_reader_lock(&self->lock);
+	KotoTrack * track = g_hash_table_lookup(self->tracks_by_uniqueish_key, key);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return track;
+}
+
+static gboolean koto_cartographer_table_contains(
+	KotoCartographer * self,
+	GHashTable * table,
+	gchar * uuid
+) {
+	g_rw_lock_reader_lock(&self->lock);
+	gboolean contains = g_hash_table_contains(table, uuid);
+	g_rw_lock_reader_unlock(&self->lock);
+
+	return contains;
 }
 
 gboolean koto_cartographer_has_album(
@@ -596,7 +1126,7 @@ gboolean koto_cartographer_has_album_by_uuid(
 		return FALSE;
 	}
 
-	return g_hash_table_contains(self->albums, album_uuid);
+	return koto_cartographer_table_contains(self, self->albums, album_uuid);
 }
 
 gboolean koto_cartographer_has_artist(
@@ -626,7 +1156,7 @@ gboolean koto_cartographer_has_artist_by_uuid(
 		return FALSE;
 	}
 
-	return g_hash_table_contains(self->artists, artist_uuid);
+	return koto_cartographer_table_contains(self, self->artists, artist_uuid);
 }
 
 gboolean koto_cartographer_has_library(
@@ -657,7 +1187,7 @@ gboolean koto_cartographer_has_library_by_uuid(
 		return FALSE;
 	}
 
-	return g_hash_table_contains(self->libraries, library_uuid);
+	return koto_cartographer_table_contains(self, self->libraries, library_uuid);
 }
 
 gboolean koto_cartographer_has_playlist(
@@ -687,7 +1217,7 @@ gboolean koto_cartographer_has_playlist_by_uuid(
 		return FALSE;
 	}
 
-	return g_hash_table_contains(self->playlists, playlist_uuid);
+	return koto_cartographer_table_contains(self, self->playlists, playlist_uuid);
 }
 
 gboolean koto_cartographer_has_track(
@@ -717,7 +1247,7 @@ gboolean koto_cartographer_has_track_by_uuid(
 		return FALSE;
 	}
 
-	return g_hash_table_contains(self->tracks, track_uuid);
+	return koto_cartographer_table_contains(self, self->tracks, track_uuid);
 }
 
 void koto_cartographer_remove_album(
@@ -747,11 +1277,18 @@ void koto_cartographer_remove_album_by_uuid(
 		return;
 	}
 
-	if (!g_hash_table_contains(self->albums, album_uuid)) { // Album does not exist in albums
+	g_rw_lock_writer_lock(&self->lock);
+	KotoAlbum * album = g_hash_table_lookup(self->albums, album_uuid);
+
+	if (album == NULL) { // Album does not exist in albums
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
 	g_hash_table_remove(self->albums, album_uuid);
+	g_rw_lock_writer_unlock(&self->lock);
+
+	g_signal_handlers_disconnect_by_data(album, self);
 
 	g_signal_emit(
 		self,
@@ -759,6 +1296,8 @@ void koto_cartographer_remove_album_by_uuid(
 		0,
 		album_uuid
 	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_ALBUMS_REMOVED, g_strdup(album_uuid));
 }
 
 void koto_cartographer_remove_artist(
@@ -776,8 +1315,12 @@ void koto_cartographer_remove_artist(
 	gchar * artist_uuid = koto_artist_get_uuid(artist);
 	gchar * artist_name = koto_artist_get_name(artist);
 
+	g_rw_lock_writer_lock(&self->lock);
 	g_hash_table_remove(self->artists_name_to_uuid, artist_name); // Add the UUID as a value with the key being the name of the artist
 	g_hash_table_remove(self->artists, artist_uuid);
+	g_rw_lock_writer_unlock(&self->lock);
+
+	g_signal_handlers_disconnect_by_data(artist, self);
 
 	g_signal_emit(
 		self,
@@ -786,6 +1329,8 @@ void koto_cartographer_remove_artist(
 		artist_uuid,
 		artist_name
 	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_ARTISTS_REMOVED, g_object_ref(artist));
 }
 
 void koto_cartographer_remove_artist_by_uuid(
@@ -800,28 +1345,13 @@ void koto_cartographer_remove_artist_by_uuid(
 		return;
 	}
 
-	if (!g_hash_table_contains(self->artists, artist_uuid)) { // Not in hash table
-		return;
-	}
-
 	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(self, artist_uuid);
 
-	if (!KOTO_IS_ARTIST(artist)) {
+	if (!KOTO_IS_ARTIST(artist)) { // Not in hash table
 		return;
 	}
 
-	gchar * artist_name = koto_artist_get_name(artist);
-
-	g_hash_table_remove(self->artists_name_to_uuid, artist_name); // Add the UUID as a value with the key being the name of the artist
-	g_hash_table_remove(self->artists, artist_uuid);
-
-	g_signal_emit(
-		self,
-		cartographer_signals[SIGNAL_ARTIST_REMOVED],
-		0,
-		artist_uuid,
-		artist_name
-	);
+	koto_cartographer_remove_artist(self, artist);
 }
 
 void koto_cartographer_remove_playlist(
@@ -850,12 +1380,14 @@ void koto_cartographer_remove_playlist_by_uuid(
 		return;
 	}
 
-	if (!g_hash_table_contains(self->playlists, playlist_uuid)) { // Not in hash table
+	g_rw_lock_writer_lock(&self->lock);
+	gboolean removed = g_hash_table_remove(self->playlists, playlist_uuid);
+	g_rw_lock_writer_unlock(&self->lock);
+
+	if (!removed) { // Not in hash table
 		return;
 	}
 
-	g_hash_table_remove(self->playlists, playlist_uuid);
-
 	g_signal_emit(
 		self,
 		cartographer_signals[SIGNAL_PLAYLIST_REMOVED],
@@ -891,11 +1423,19 @@ void koto_cartographer_remove_track_by_uuid(
 		return;
 	}
 
-	if (!g_hash_table_contains(self->tracks, track_uuid)) { // Not in hash table
+	g_rw_lock_writer_lock(&self->lock);
+	KotoTrack * track = g_hash_table_lookup(self->tracks, track_uuid);
+
+	if (track == NULL) { // Not in hash table
+		g_rw_lock_writer_unlock(&self->lock);
 		return;
 	}
 
+	koto_cartographer_unindex_track(self, track);
 	g_hash_table_remove(self->tracks, track_uuid);
+	g_rw_lock_writer_unlock(&self->lock);
+
+	g_signal_handlers_disconnect_by_data(track, self);
 
 	g_signal_emit(
 		self,
@@ -903,6 +1443,8 @@ void koto_cartographer_remove_track_by_uuid(
 		0,
 		track_uuid
 	);
+
+	koto_cartographer_queue_change(self, KOTO_CARTOGRAPHER_CHANGE_TRACKS_REMOVED, g_strdup(track_uuid));
 }
 
 KotoCartographer * koto_cartographer_new() {
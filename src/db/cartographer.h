@@ -62,11 +62,22 @@ void koto_cartographer_add_playlist(
 	KotoPlaylist * playlist
 );
 
+gchar * koto_cartographer_build_uniqueish_key(
+	const gchar * artist_name,
+	const gchar * album_name,
+	const gchar * track_name
+);
+
 void koto_cartographer_add_track(
 	KotoCartographer * self,
 	KotoTrack * track
 );
 
+void koto_cartographer_add_tracks(
+	KotoCartographer * self,
+	GPtrArray * tracks
+);
+
 void koto_cartographer_emit_playlist_added(
 	KotoPlaylist * playlist,
 	KotoCartographer * self
@@ -77,7 +88,7 @@ KotoAlbum * koto_cartographer_get_album_by_uuid(
 	gchar * album_uuid
 );
 
-GHashTable * koto_cartographer_get_artists(KotoCartographer * self);
+GList * koto_cartographer_get_artists(KotoCartographer * self);
 
 KotoArtist * koto_cartographer_get_artist_by_name(
 	KotoCartographer * self,
@@ -111,7 +122,7 @@ KotoPlaylist * koto_cartographer_get_playlist_by_uuid(
 	gchar * playlist_uuid
 );
 
-GHashTable * koto_cartographer_get_playlists(KotoCartographer * self);
+GList * koto_cartographer_get_playlists(KotoCartographer * self);
 
 KotoTrack * koto_cartographer_get_track_by_uuid(
 	KotoCartographer * self,
@@ -23,6 +23,9 @@
 #include "db.h"
 #include "../koto-paths.h"
 
+#define KOTO_DB_READER_PRAGMAS "PRAGMA cache_size = -8000; PRAGMA mmap_size = 268435456;"
+#define KOTO_DB_WRITER_PRAGMAS "PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL; PRAGMA cache_size = -16000; PRAGMA mmap_size = 268435456;"
+
 extern gchar * koto_path_to_db;
 
 int KOTO_DB_SUCCESS = 0;
@@ -33,7 +36,237 @@ sqlite3 * koto_db = NULL;
 gchar * db_filepath = NULL;
 gboolean created_new_db = FALSE;
 
+static const gchar * koto_db_writer_queries[KOTO_DB_STATEMENT_COUNT] = {
+	[KOTO_DB_STATEMENT_UPSERT_ARTIST] = "INSERT INTO artists(id, name, art_path) VALUES(?1, quote(?2), NULL)"
+										"ON CONFLICT(id) DO UPDATE SET name=excluded.name, art_path=excluded.art_path;",
+	[KOTO_DB_STATEMENT_UPSERT_ARTIST_PATH] = "INSERT INTO libraries_artists(id, artist_id, path) VALUES(?1, ?2, quote(?3))"
+											 "ON CONFLICT(id, artist_id) DO UPDATE SET path=excluded.path;",
+	[KOTO_DB_STATEMENT_UPSERT_ALBUM] = "INSERT INTO albums(id, artist_id, name, description, narrator, art_path, genres, year) VALUES(?1, ?2, quote(?3), quote(?4), quote(?5), quote(?6), ?7, ?8)"
+									   "ON CONFLICT(id) DO UPDATE SET artist_id=excluded.artist_id, name=excluded.name, description=excluded.description, narrator=excluded.narrator, art_path=excluded.art_path, genres=excluded.genres, year=excluded.year;",
+	[KOTO_DB_STATEMENT_UPSERT_ALBUM_PATH] = "INSERT INTO libraries_albums(id, album_id, path) VALUES(?1, ?2, quote(?3))"
+											"ON CONFLICT(id, album_id) DO UPDATE SET path=excluded.path;",
+	[KOTO_DB_STATEMENT_UPSERT_TRACK] = "INSERT INTO tracks(id, artist_id, album_id, name, disc, position, duration, genres) VALUES(?1, ?2, ?3, quote(?4), ?5, ?6, ?7, ?8)"
+									   "ON CONFLICT(id) DO UPDATE SET album_id=excluded.album_id, artist_id=excluded.artist_id, name=excluded.name, disc=excluded.disc, position=excluded.position, duration=excluded.duration, genres=excluded.genres;",
+	[KOTO_DB_STATEMENT_UPSERT_TRACK_PATH] = "INSERT INTO libraries_tracks(id, track_id, path) VALUES(?1, ?2, quote(?3))"
+											"ON CONFLICT(id, track_id) DO UPDATE SET path=excluded.path;",
+	[KOTO_DB_STATEMENT_UPSERT_FILE] = "INSERT INTO files(library_id, path, mtime, size, inode, track_id) VALUES(?1, quote(?2), ?3, ?4, ?5, ?6)"
+									  "ON CONFLICT(library_id, path) DO UPDATE SET mtime=excluded.mtime, size=excluded.size, inode=excluded.inode, track_id=excluded.track_id;",
+	[KOTO_DB_STATEMENT_DELETE_FILES] = "DELETE FROM files WHERE " KOTO_DB_FILES_UNDER_PATH ";",
+	[KOTO_DB_STATEMENT_DELETE_TRACK] = "DELETE FROM tracks WHERE id=?1;", // Cascades to the track's paths, fingerprints and playlist entries
+	[KOTO_DB_STATEMENT_DELETE_ARTIST] = "DELETE FROM artists WHERE id=?1;", // Cascades to albums and paths
+	[KOTO_DB_STATEMENT_DELETE_ALBUM] = "DELETE FROM albums WHERE id=?1;", // Cascades to its paths
+};
+
+static const gchar * koto_db_migrations[] = { // Migrations to apply on top of the tables, in order. Index N brings the database to user_version N + 1, never change or reorder existing entries
+	"CREATE INDEX IF NOT EXISTS tracks_album_id ON tracks(album_id);"
+	"CREATE INDEX IF NOT EXISTS tracks_artist_id ON tracks(artist_id);"
+	"CREATE INDEX IF NOT EXISTS libraries_tracks_track_id ON libraries_tracks(track_id);"
+	"CREATE INDEX IF NOT EXISTS libraries_albums_album_id ON libraries_albums(album_id);"
+	"CREATE INDEX IF NOT EXISTS playlist_tracks_playlist_id_position ON playlist_tracks(playlist_id, position);",
+	"ALTER TABLE playlist_meta ADD COLUMN shuffle_seed int DEFAULT 0;",
+};
+
+typedef enum {
+	KOTO_DB_WRITER_STOPPED, // Not started yet, so writes are run by the caller
+	KOTO_DB_WRITER_RUNNING, // Writes are queued for our writer thread
+	KOTO_DB_WRITER_CLOSED // Database is closed, so writes are dropped
+} KotoDbWriterState;
+
+typedef enum {
+	KOTO_DB_WRITE_SQL,
+	KOTO_DB_WRITE_STATEMENT,
+	KOTO_DB_WRITE_QUIT
+} KotoDbWriteType;
+
+typedef enum {
+	KOTO_DB_VALUE_NULL, // Unbound values are NULL
+	KOTO_DB_VALUE_INT,
+	KOTO_DB_VALUE_TEXT
+} KotoDbValueType;
+
+typedef struct {
+	KotoDbValueType type;
+	sqlite3_int64 number;
+	gchar * text;
+} KotoDbValue;
+
+struct _KotoDbWrite {
+	KotoDbWriteType type;
+	gchar * sql; // SQL to execute for KOTO_DB_WRITE_SQL
+	KotoDbStatement statement; // Cached statement to step for KOTO_DB_WRITE_STATEMENT
+	GArray * values; // KotoDbValues to bind to the statement, by parameter index - 1
+	gchar * err_msg;
+	gboolean fatal;
+};
+
+static sqlite3_stmt * koto_db_writer_statements[KOTO_DB_STATEMENT_COUNT] = {
+	NULL
+}; // Only ever used from the writer thread
+
+static GAsyncQueue * koto_db_writer_queue = NULL; // KotoDbWrites waiting for our writer thread
+static GThread * koto_db_writer_thread = NULL;
+static GMutex koto_db_writer_lock; // Guards our writer state, so nothing can be queued after we have told the writer to quit
+static KotoDbWriterState koto_db_writer_state = KOTO_DB_WRITER_STOPPED;
+static GMutex koto_db_writer_batch_lock; // Guards our batch depth
+static guint koto_db_writer_batch_depth = 0; // Number of callers that currently want writes batched
+static gint koto_db_writer_batch_size = 1; // Maximum number of queued writes to group into each transaction
+
+static void koto_db_reader_close(gpointer reader) {
+	sqlite3_close(reader);
+}
+
+static GPrivate koto_db_reader = G_PRIVATE_INIT(koto_db_reader_close); // Each thread that reads gets its own connection, closed when the thread exits
+
+static void koto_db_value_clear(KotoDbValue * value) {
+	g_free(value->text);
+}
+
+static void koto_db_write_free(KotoDbWrite * write) {
+	g_free(write->sql);
+	g_free(write->err_msg);
+
+	if (write->values != NULL) {
+		g_array_unref(write->values);
+	}
+
+	g_free(write);
+}
+
+static int koto_db_exec(
+	const gchar * operation,
+	const gchar * transaction_err_msg,
+	gboolean fatal
+) {
+	gchar * commit_op_errmsg = NULL;
+	int rc = sqlite3_exec(koto_db, operation, 0, 0, &commit_op_errmsg);
+
+	if (rc != SQLITE_OK) {
+		(fatal) ? g_critical("%s: %s", transaction_err_msg, commit_op_errmsg) : g_warning("%s: %s", transaction_err_msg, commit_op_errmsg);
+	}
+
+	if (commit_op_errmsg != NULL) {
+		sqlite3_free(commit_op_errmsg);
+	}
+
+	return rc;
+}
+
+/**
+ * Hand a write to our writer thread, taking ownership of it.
+ * Returns FALSE without taking ownership when the writer has not started yet, in which case the caller should run the write itself. Writes made after the database was closed, such as by an indexing thread that is still running, are dropped.
+ **/
+static gboolean koto_db_writer_queue_write(KotoDbWrite * write) {
+	g_mutex_lock(&koto_db_writer_lock);
+	KotoDbWriterState state = koto_db_writer_state;
+
+	if (state == KOTO_DB_WRITER_RUNNING) { // Writer is still accepting writes
+		g_async_queue_push(koto_db_writer_queue, write);
+	}
+
+	g_mutex_unlock(&koto_db_writer_lock);
+
+	if (state == KOTO_DB_WRITER_CLOSED) { // Too late to write
+		g_warning("Dropping a write made after our database was closed: %s", write->err_msg);
+		koto_db_write_free(write);
+	}
+
+	return state != KOTO_DB_WRITER_STOPPED;
+}
+
+static void koto_db_writer_run(KotoDbWrite * write) {
+	if (write->type == KOTO_DB_WRITE_SQL) { // Plain SQL
+		koto_db_exec(write->sql, write->err_msg, write->fatal);
+		return;
+	}
+
+	if (koto_db_writer_statements[write->statement] == NULL) { // Not prepared yet
+		if (sqlite3_prepare_v3(koto_db, koto_db_writer_queries[write->statement], -1, SQLITE_PREPARE_PERSISTENT, &koto_db_writer_statements[write->statement], NULL) != SQLITE_OK) { // Failed to prepare
+			g_warning("Failed to prepare statement: %s", sqlite3_errmsg(koto_db));
+			koto_db_writer_statements[write->statement] = NULL;
+			return;
+		}
+	}
+
+	sqlite3_stmt * stmt = koto_db_writer_statements[write->statement];
+
+	for (guint i = 0; i < write->values->len; i++) { // For each value to bind
+		KotoDbValue * value = &g_array_index(write->values, KotoDbValue, i);
+
+		if (value->type == KOTO_DB_VALUE_INT) {
+			sqlite3_bind_int64(stmt, i + 1, value->number);
+		} else if (value->type == KOTO_DB_VALUE_TEXT) {
+			sqlite3_bind_text(stmt, i + 1, value->text, -1, SQLITE_STATIC); // Write outlives the step
+		} else {
+			sqlite3_bind_null(stmt, i + 1);
+		}
+	}
+
+	if (sqlite3_step(stmt) != SQLITE_DONE) { // Failed to write
+		g_warning("%s: %s", write->err_msg, sqlite3_errmsg(koto_db));
+	}
+
+	sqlite3_reset(stmt); // Reset so we can reuse it
+	sqlite3_clear_bindings(stmt); // Don't leak values into the next use
+}
+
+static gpointer koto_db_writer_thread_func(gpointer user_data) {
+	(void) user_data;
+
+	gboolean quit = FALSE;
+
+	while (!quit) {
+		KotoDbWrite * write = g_async_queue_pop(koto_db_writer_queue); // Wait for something to write
+		guint batch_size = (guint) g_atomic_int_get(&koto_db_writer_batch_size);
+		guint written = 0;
+
+		koto_db_exec("BEGIN;", "Failed to begin a batch of writes", FALSE);
+
+		while (write != NULL) { // Group whatever is already queued into this transaction, up to our batch size
+			if (write->type == KOTO_DB_WRITE_QUIT) { // Everything before this has been written
+				quit = TRUE;
+				koto_db_write_free(write);
+				break;
+			}
+
+			koto_db_writer_run(write);
+			koto_db_write_free(write);
+			written++;
+
+			write = (written < batch_size) ? g_async_queue_try_pop(koto_db_writer_queue) : NULL;
+		}
+
+		koto_db_exec("COMMIT;", "Failed to commit batched writes", FALSE);
+	}
+
+	for (guint i = 0; i < KOTO_DB_STATEMENT_COUNT; i++) { // For each statement we may have prepared
+		sqlite3_finalize(koto_db_writer_statements[i]); // Finalizing NULL is a no-op
+		koto_db_writer_statements[i] = NULL;
+	}
+
+	return NULL;
+}
+
 void close_db() {
+	g_mutex_lock(&koto_db_writer_lock);
+	gboolean was_running = koto_db_writer_state == KOTO_DB_WRITER_RUNNING;
+	koto_db_writer_state = KOTO_DB_WRITER_CLOSED; // Drop anything written from here on, such as by indexing threads we do not wait for
+
+	if (was_running) { // Have our writer thread
+		KotoDbWrite * quit = g_new0(KotoDbWrite, 1);
+		quit->type = KOTO_DB_WRITE_QUIT;
+		g_async_queue_push(koto_db_writer_queue, quit); // Pushed under our lock, so it is always the last write
+	}
+
+	g_mutex_unlock(&koto_db_writer_lock);
+
+	if (was_running) {
+		g_thread_join(koto_db_writer_thread); // Wait for every queued write to be committed
+		koto_db_writer_thread = NULL;
+		g_async_queue_unref(koto_db_writer_queue);
+		koto_db_writer_queue = NULL;
+	}
+
+	g_private_replace(&koto_db_reader, NULL); // Close the reader connection for this thread
 	sqlite3_close(koto_db);
 }
 
@@ -44,12 +277,64 @@ int create_db_tables() {
 									  "CREATE TABLE IF NOT EXISTS libraries_albums(id string, album_id string, path string, PRIMARY KEY (id, album_id) FOREIGN KEY(album_id) REFERENCES albums(id) ON DELETE CASCADE);"
 									  "CREATE TABLE IF NOT EXISTS libraries_artists(id string, artist_id string, path string, PRIMARY KEY(id, artist_id) FOREIGN KEY(artist_id) REFERENCES artists(id) ON DELETE CASCADE);"
 									  "CREATE TABLE IF NOT EXISTS libraries_tracks(id string, track_id string, path string, PRIMARY KEY(id, track_id) FOREIGN KEY(track_id) REFERENCES tracks(id) ON DELETE CASCADE);"
+									  "CREATE TABLE IF NOT EXISTS files(library_id string, path string, mtime int, size int, inode int, track_id string, PRIMARY KEY(library_id, path) FOREIGN KEY(track_id) REFERENCES tracks(id) ON DELETE CASCADE);"
 									  "CREATE TABLE IF NOT EXISTS playlist_meta(id string UNIQUE PRIMARY KEY, name string, art_path string, preferred_model int, album_id string, track_id string, playback_position_of_track int);"
 									  "CREATE TABLE IF NOT EXISTS playlist_tracks(position INTEGER PRIMARY KEY AUTOINCREMENT, playlist_id string, track_id string, FOREIGN KEY(playlist_id) REFERENCES playlist_meta(id), FOREIGN KEY(track_id) REFERENCES tracks(id) ON DELETE CASCADE);";
 
 	return (new_transaction(tables_creation_queries, "Failed to create required tables", TRUE) == SQLITE_OK) ? KOTO_DB_SUCCESS : KOTO_DB_FAIL;
 }
 
+int get_db_version() {
+	sqlite3_stmt * stmt = NULL;
+	int version = -1;
+
+	if (sqlite3_prepare_v2(koto_db, "PRAGMA user_version;", -1, &stmt, NULL) != SQLITE_OK) { // Failed to prepare
+		g_critical("Failed to get our database version: %s", sqlite3_errmsg(koto_db));
+		return version;
+	}
+
+	if (sqlite3_step(stmt) == SQLITE_ROW) { // Got our version
+		version = sqlite3_column_int(stmt, 0);
+	}
+
+	sqlite3_finalize(stmt);
+	return version;
+}
+
+/**
+ * Apply any migrations newer than the version recorded in the database.
+ * Each migration and its version bump are committed together, so an interrupted migration is simply retried on the next start.
+ **/
+int migrate_db() {
+	int version = get_db_version();
+
+	if (version < 0) { // Failed to get the version
+		return KOTO_DB_FAIL;
+	}
+
+	int latest_version = (int) G_N_ELEMENTS(koto_db_migrations);
+
+	if (version > latest_version) { // Database was migrated by a newer Koto
+		g_warning("Database version %d is newer than the %d we know about, leaving it as is", version, latest_version);
+		return KOTO_DB_SUCCESS;
+	}
+
+	for (; version < latest_version; version++) { // For each migration we have not applied yet
+		gchar * migration = g_strdup_printf("BEGIN;%sPRAGMA user_version = %d;COMMIT;", koto_db_migrations[version], version + 1);
+		int rc = new_transaction(migration, "Failed to migrate our database", TRUE);
+		g_free(migration);
+
+		if (rc != SQLITE_OK) { // Failed to apply the migration
+			new_transaction("ROLLBACK;", "Failed to roll back our database migration", FALSE);
+			return KOTO_DB_FAIL;
+		}
+
+		g_message("Migrated our database to version %d", version + 1);
+	}
+
+	return KOTO_DB_SUCCESS;
+}
+
 int enable_foreign_keys() {
 	gchar * commit_op = g_strdup("PRAGMA foreign_keys = ON;");
 	const gchar * transaction_err_msg = "Failed to enable foreign key support. Ensure your sqlite3 is compiled with neither SQLITE_OMIT_FOREIGN_KEY or SQLITE_OMIT_TRIGGER defined";
@@ -68,18 +353,18 @@ int new_transaction(
 	const gchar * transaction_err_msg,
 	gboolean fatal
 ) {
-	gchar * commit_op_errmsg = NULL;
-	int rc = sqlite3_exec(koto_db, operation, 0, 0, &commit_op_errmsg);
-
-	if (rc != SQLITE_OK) {
-		(fatal) ? g_critical("%s: %s", transaction_err_msg, commit_op_errmsg) : g_warning("%s: %s", transaction_err_msg, commit_op_errmsg);
-	}
+	KotoDbWrite * write = g_new0(KotoDbWrite, 1);
+	write->type = KOTO_DB_WRITE_SQL;
+	write->sql = g_strdup(operation);
+	write->err_msg = g_strdup(transaction_err_msg);
+	write->fatal = fatal;
 
-	if (commit_op_errmsg == NULL) {
-		g_free(commit_op_errmsg);
+	if (koto_db_writer_queue_write(write)) { // Queued for our writer, which reports any errors
+		return SQLITE_OK;
 	}
 
-	return rc;
+	koto_db_write_free(write); // Writer has not started yet, so run it ourselves
+	return koto_db_exec(operation, transaction_err_msg, fatal);
 }
 
 int open_db() {
@@ -98,13 +383,150 @@ int open_db() {
 		return KOTO_DB_FAIL;
 	}
 
+	new_transaction(KOTO_DB_WRITER_PRAGMAS, "Failed to enable write-ahead logging", FALSE); // Let readers carry on while we write, and only sync on checkpoints
+
 	if (create_db_tables() != KOTO_DB_SUCCESS) { // Failed to create our database tables
 		return KOTO_DB_FAIL;
 	}
 
+	if (migrate_db() != KOTO_DB_SUCCESS) { // Failed to bring our database up to date
+		return KOTO_DB_FAIL;
+	}
+
 	if (ret == KOTO_DB_NEW) {
 		created_new_db = TRUE;
 	}
 
+	koto_db_writer_start(); // Everything from here on is written by our writer thread
 	return ret;
 }
+
+/**
+ * Allow the writer to group up to batch_size queued writes into each transaction until the matching koto_db_writer_end_batch, rather than giving each write its own transaction and sync.
+ * Batches may be nested, for example by concurrent indexing of multiple libraries, and only the outermost end goes back to single writes.
+ **/
+void koto_db_writer_begin_batch(guint batch_size) {
+	g_mutex_lock(&koto_db_writer_batch_lock);
+
+	if ((gint) batch_size > g_atomic_int_get(&koto_db_writer_batch_size)) { // Larger batch size requested
+		g_atomic_int_set(&koto_db_writer_batch_size, (gint) batch_size);
+	}
+
+	koto_db_writer_batch_depth++;
+	g_mutex_unlock(&koto_db_writer_batch_lock);
+}
+
+void koto_db_writer_end_batch() {
+	g_mutex_lock(&koto_db_writer_batch_lock);
+
+	if (koto_db_writer_batch_depth > 0) { // In a batch
+		koto_db_writer_batch_depth--;
+
+		if (koto_db_writer_batch_depth == 0) { // Outermost batch ended
+			g_atomic_int_set(&koto_db_writer_batch_size, 1);
+		}
+	}
+
+	g_mutex_unlock(&koto_db_writer_batch_lock);
+}
+
+/**
+ * Create a write for one of our cached statements. Bind its parameters then hand it to koto_db_writer_push, which takes ownership.
+ **/
+KotoDbWrite * koto_db_writer_new_write(KotoDbStatement statement) {
+	KotoDbWrite * write = g_new0(KotoDbWrite, 1);
+	write->type = KOTO_DB_WRITE_STATEMENT;
+	write->statement = statement;
+	write->values = g_array_new(FALSE, TRUE, sizeof(KotoDbValue)); // Zeroed so skipped parameters are NULL
+	g_array_set_clear_func(write->values, (GDestroyNotify) koto_db_value_clear);
+	return write;
+}
+
+static KotoDbValue * koto_db_write_get_value(
+	KotoDbWrite * write,
+	int index
+) {
+	if (write->values->len < (guint) index) { // Grow to fit this parameter
+		g_array_set_size(write->values, index);
+	}
+
+	KotoDbValue * value = &g_array_index(write->values, KotoDbValue, index - 1);
+	koto_db_value_clear(value); // Parameter may be bound more than once
+	value->text = NULL;
+	return value;
+}
+
+void koto_db_write_bind_int64(
+	KotoDbWrite * write,
+	int index,
+	gint64 number
+) {
+	KotoDbValue * value = koto_db_write_get_value(write, index);
+	value->type = KOTO_DB_VALUE_INT;
+	value->number = number;
+}
+
+void koto_db_write_bind_null(
+	KotoDbWrite * write,
+	int index
+) {
+	KotoDbValue * value = koto_db_write_get_value(write, index);
+	value->type = KOTO_DB_VALUE_NULL;
+}
+
+void koto_db_write_bind_text(
+	KotoDbWrite * write,
+	int index,
+	const gchar * text
+) {
+	KotoDbValue * value = koto_db_write_get_value(write, index);
+	value->type = (text != NULL) ? KOTO_DB_VALUE_TEXT : KOTO_DB_VALUE_NULL;
+	value->text = g_strdup(text);
+}
+
+void koto_db_writer_push(
+	KotoDbWrite * write,
+	const gchar * transaction_err_msg
+) {
+	write->err_msg = g_strdup(transaction_err_msg);
+
+	if (!koto_db_writer_queue_write(write)) { // Writer has not started yet
+		koto_db_writer_run(write);
+		koto_db_write_free(write);
+	}
+}
+
+/**
+ * Get the read-only connection for the calling thread, opening it on first use.
+ * Readers never wait on our writer thread, though they will not see writes that are still queued.
+ **/
+sqlite3 * koto_db_get_reader() {
+	sqlite3 * reader = g_private_get(&koto_db_reader);
+
+	if (reader != NULL) { // Already have a connection for this thread
+		return reader;
+	}
+
+	if (sqlite3_open_v2(koto_path_to_db, &reader, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK) { // Failed to open
+		g_critical("Failed to open a reader for our database: %s", sqlite3_errmsg(reader));
+		sqlite3_close(reader);
+		return koto_db; // Fall back to the shared connection rather than not reading at all
+	}
+
+	sqlite3_exec(reader, KOTO_DB_READER_PRAGMAS, NULL, NULL, NULL);
+	g_private_set(&koto_db_reader, reader);
+
+	return reader;
+}
+
+void koto_db_writer_start() {
+	g_mutex_lock(&koto_db_writer_lock);
+
+	if (koto_db_writer_state == KOTO_DB_WRITER_STOPPED) { // Not started or closed yet
+		koto_db_writer_queue = g_async_queue_new();
+		koto_db_writer_thread = g_thread_new("writing-to-db", koto_db_writer_thread_func, NULL);
+		koto_db_writer_state = KOTO_DB_WRITER_RUNNING;
+	}
+
+	g_mutex_unlock(&koto_db_writer_lock);
+}
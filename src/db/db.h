@@ -22,12 +22,32 @@ extern int KOTO_DB_SUCCESS;
 extern int KOTO_DB_NEW;
 extern int KOTO_DB_FAIL;
 
+// Files at or under the relative path ?2 in the library ?1. Paths are stored quoted, and '0' sorts right after '/', so the range covers exactly the subtree
+#define KOTO_DB_FILES_UNDER_PATH "library_id=?1 AND (path=quote(?2) OR (path > ('''' || replace(?2, '''', '''''') || '/') AND path < ('''' || replace(?2, '''', '''''') || '0')))"
+
+typedef enum {
+	KOTO_DB_STATEMENT_UPSERT_ARTIST,
+	KOTO_DB_STATEMENT_UPSERT_ARTIST_PATH,
+	KOTO_DB_STATEMENT_UPSERT_ALBUM,
+	KOTO_DB_STATEMENT_UPSERT_ALBUM_PATH,
+	KOTO_DB_STATEMENT_UPSERT_TRACK,
+	KOTO_DB_STATEMENT_UPSERT_TRACK_PATH,
+	KOTO_DB_STATEMENT_UPSERT_FILE,
+	KOTO_DB_STATEMENT_DELETE_FILES,
+	KOTO_DB_STATEMENT_DELETE_TRACK,
+	KOTO_DB_STATEMENT_DELETE_ARTIST,
+	KOTO_DB_STATEMENT_DELETE_ALBUM,
+	KOTO_DB_STATEMENT_COUNT
+} KotoDbStatement;
+
 void close_db();
 
 int create_db_tables();
 
 gchar * get_db_path();
 
+int get_db_version();
+
 int enable_foreign_keys();
 
 int have_existing_db();
@@ -38,4 +58,40 @@ int new_transaction(
 	gboolean fatal
 );
 
+int migrate_db();
+
 int open_db();
+
+typedef struct _KotoDbWrite KotoDbWrite;
+
+sqlite3 * koto_db_get_reader();
+
+void koto_db_writer_begin_batch(guint batch_size);
+
+void koto_db_writer_end_batch();
+
+KotoDbWrite * koto_db_writer_new_write(KotoDbStatement statement);
+
+void koto_db_writer_push(
+	KotoDbWrite * write,
+	const gchar * transaction_err_msg
+);
+
+void koto_db_writer_start();
+
+void koto_db_write_bind_int64(
+	KotoDbWrite * write,
+	int index,
+	gint64 number
+);
+
+void koto_db_write_bind_null(
+	KotoDbWrite * write,
+	int index
+);
+
+void koto_db_write_bind_text(
+	KotoDbWrite * write,
+	int index,
+	const gchar * text
+);
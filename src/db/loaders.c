@@ -18,12 +18,120 @@
 #include "cartographer.h"
 #include "db.h"
 #include "loaders.h"
+#include "../config/config.h"
 #include "../indexer/album-playlist-funcs.h"
 #include "../indexer/structs.h"
 #include "../koto-utils.h"
+#include "../koto-window.h"
+
+#define KOTO_LOADER_STEPS_PER_IDLE 200
 
 extern KotoCartographer * koto_maps;
-extern sqlite3 * koto_db;
+extern KotoConfig * config;
+extern KotoWindow * main_window;
+
+typedef enum {
+	KOTO_LOADER_STEP_ARTIST,
+	KOTO_LOADER_STEP_ALBUM,
+	KOTO_LOADER_STEP_TRACK,
+	KOTO_LOADER_STEP_FINALIZE_ALBUMS,
+	KOTO_LOADER_STEP_PLAYLIST,
+	KOTO_LOADER_STEP_PLAYLIST_TRACK,
+	KOTO_LOADER_STEP_FINISH_PLAYLISTS
+} KotoLoaderStepType;
+
+typedef struct {
+	int num_columns;
+	gchar ** fields;
+} KotoLoaderRow;
+
+typedef struct {
+	KotoTrack * track;
+	KotoArtist * artist;
+	KotoAlbum * album;
+} KotoLoaderTrack;
+
+typedef struct {
+	KotoLoaderStepType type;
+	KotoLoaderRow * row; // Row to create an object from, NULL for steps that finish a pass
+} KotoLoaderStep;
+
+typedef struct {
+	gchar * uuid;
+	gchar * current_track_uuid;
+	guint64 current_track_playback_position;
+	GPtrArray * tracks; // Tracks to add in one go once all playlist tracks are read
+} KotoLoaderPlaylist;
+
+typedef struct {
+	GHashTable * artist_paths; // Artist UUIDs to a GPtrArray of their library UUID and relative path pairs
+	GHashTable * track_paths; // Track UUIDs to a GPtrArray of their library UUID and relative path pairs
+	GHashTable * playlists; // Playlist UUIDs to the KotoLoaderPlaylist we still need to finish once their tracks are loaded
+	GList * artists; // Artists to finalize once all albums have been loaded
+	GList * albums; // Albums to finalize once all tracks have been loaded
+	GHashTable * priority_artists; // UUIDs of the artists, albums, tracks and playlists we were last playing, loaded before anything else
+	GHashTable * priority_albums;
+	GHashTable * priority_tracks;
+	GHashTable * priority_playlists;
+	GPtrArray * artist_rows; // Rows read by the loading thread, waiting to be turned into objects on the main thread
+	GPtrArray * album_rows;
+	GPtrArray * track_rows;
+	GPtrArray * playlist_rows;
+	GPtrArray * playlist_track_rows;
+	GQueue * steps; // KotoLoaderSteps left to run on the main thread
+	GPtrArray * pending_tracks; // KotoLoaderTracks created in this batch, not yet added to the cartographer
+	gint64 start_time;
+	gint64 read_time;
+	guint num_artists;
+	guint num_albums;
+	guint num_tracks;
+	guint num_playlists;
+} KotoLoaderState;
+
+static void koto_loader_playlist_free(KotoLoaderPlaylist * pending) {
+	g_free(pending->uuid);
+	g_free(pending->current_track_uuid);
+	g_clear_pointer(&pending->tracks, g_ptr_array_unref);
+	g_free(pending);
+}
+
+static void koto_loader_add_path(
+	GHashTable * paths_table,
+	char ** fields
+) {
+	gchar * owner_uuid = koto_utils_string_unquote(fields[1]); // Artist or track UUID
+	GPtrArray * paths = g_hash_table_lookup(paths_table, owner_uuid);
+
+	if (paths == NULL) { // First path for this artist or track
+		paths = g_ptr_array_new_with_free_func(g_free);
+		g_hash_table_insert(paths_table, owner_uuid, paths); // Table takes ownership of the UUID
+	} else {
+		g_free(owner_uuid);
+	}
+
+	g_ptr_array_add(paths, koto_utils_string_unquote(fields[0])); // Pairs are stored as library UUID followed by path
+	g_ptr_array_add(paths, koto_utils_string_unquote(fields[2]));
+}
+
+static void koto_loader_finish_playlist(
+	KotoPlaylist * playlist,
+	KotoLoaderPlaylist * pending
+) {
+	if (pending->tracks != NULL) { // Have tracks to add
+		koto_playlist_add_tracks(playlist, pending->tracks, FALSE); // Add them all at once, without re-committing them to the table
+	}
+
+	if (koto_utils_string_is_valid(pending->current_track_uuid)) { // If we have a track UUID (probably)
+		KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, pending->current_track_uuid); // Get the track UUID
+
+		if (KOTO_IS_TRACK(track)) { // If this is a track
+			koto_track_set_playback_position(track, pending->current_track_playback_position); // Set the playback position of the track
+			koto_playlist_set_track_as_current(playlist, pending->current_track_uuid); // Ensure we have this track set as the current one in the playlist
+		}
+	}
+
+	koto_playlist_mark_as_finalized(playlist); // Mark as finalized since loading should be complete
+}
 
 int process_artists(
 	void * data,
@@ -31,9 +139,10 @@ int process_artists(
 	char ** fields,
 	char ** column_names
 ) {
-	(void) data;
 	(void) num_columns;
-	(void) column_names; // Don't need any of the params
+	(void) column_names; // Don't need these
+
+	KotoLoaderState * state = data;
 
 	gchar * artist_uuid = g_strdup(koto_utils_string_unquote(fields[0])); // First column is UUID
 	gchar * artist_name = g_strdup(koto_utils_string_unquote(fields[1])); // Second column is artist name
@@ -46,30 +155,19 @@ int process_artists(
 		artist_name,          // Set name
 		NULL);
 
-	int artist_paths = sqlite3_exec(koto_db, g_strdup_printf("SELECT * FROM libraries_artists WHERE artist_id=\"%s\"", artist_uuid), process_artist_paths, artist, NULL); // Process all the paths for this given artist
-
-	if (artist_paths != SQLITE_OK) { // Failed to get our artists_paths
-		g_critical("Failed to read our paths for this artist: %s", sqlite3_errmsg(koto_db));
-		return 1;
-	}
-
-	koto_cartographer_add_artist(koto_maps, artist); // Add the artist to our global cartographer
+	GPtrArray * paths = g_hash_table_lookup(state->artist_paths, artist_uuid); // Get the paths we loaded for this artist
 
-	int albums_rc = sqlite3_exec(koto_db, g_strdup_printf("SELECT * FROM albums WHERE artist_id=\"%s\"", artist_uuid), process_albums, artist, NULL); // Process our albums
+	for (guint i = 0; (paths != NULL) && (i + 1 < paths->len); i += 2) { // For each library UUID and path pair
+		KotoLibrary * lib = koto_cartographer_get_library_by_uuid(koto_maps, g_ptr_array_index(paths, i)); // Get the library for this artist
 
-	if (albums_rc != SQLITE_OK) { // Failed to get our albums
-		g_critical("Failed to read our albums: %s", sqlite3_errmsg(koto_db));
-		return 1;
+		if (KOTO_IS_LIBRARY(lib)) { // Library still exists
+			koto_artist_set_path(artist, lib, g_ptr_array_index(paths, i + 1), FALSE); // Add the relative path from the db for this artist and lib to the Artist, do not commit
+		}
 	}
 
-	koto_artist_set_as_finalized(artist); // Indicate it is finalized
-
-	int tracks_rc = sqlite3_exec(koto_db, g_strdup_printf("SELECT * FROM tracks WHERE artist_id=\"%s\" AND album_id=''", artist_uuid), process_tracks, NULL, NULL); // Load all tracks for an artist that are NOT in an album (e.g. artists without albums)
-
-	if (tracks_rc != SQLITE_OK) { // Failed to get our tracks
-		g_critical("Failed to read our tracks: %s", sqlite3_errmsg(koto_db));
-		return 1;
-	}
+	koto_cartographer_add_artist(koto_maps, artist); // Add the artist to our global cartographer
+	state->artists = g_list_prepend(state->artists, artist);
+	state->num_artists++;
 
 	g_free(artist_uuid);
 	g_free(artist_name);
@@ -86,19 +184,8 @@ int process_artist_paths(
 	(void) num_columns;
 	(void) column_names; // Don't need these
 
-	KotoArtist * artist = (KotoArtist*) data;
-
-	gchar * library_uuid = g_strdup(koto_utils_string_unquote(fields[0]));
-	gchar * relative_path = g_strdup(koto_utils_string_unquote(fields[2]));
-
-	KotoLibrary * lib = koto_cartographer_get_library_by_uuid(koto_maps, library_uuid); // Get the library for this artist
-
-	if (!KOTO_IS_LIBRARY(lib)) { // Failed to get the library for this UUID
-		return 0;
-	}
-
-	koto_artist_set_path(artist, lib, relative_path, FALSE); // Add the relative path from the db for this artist and lib to the Artist, do not commit
-
+	KotoLoaderState * state = data;
+	koto_loader_add_path(state->artist_paths, fields); // Hold onto the path until we create the artist
 	return 0;
 }
 
@@ -111,10 +198,19 @@ int process_albums(
 	(void) num_columns;
 	(void) column_names; // Don't need these
 
-	KotoArtist * artist = (KotoArtist*) data;
+	KotoLoaderState * state = data;
 
 	gchar * album_uuid = g_strdup(koto_utils_string_unquote(fields[0]));
 	gchar * artist_uuid = g_strdup(koto_utils_string_unquote(fields[1]));
+
+	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid); // Get the artist for this album
+
+	if (!KOTO_IS_ARTIST(artist)) { // Artist no longer exists
+		g_free(album_uuid);
+		g_free(artist_uuid);
+		return 0;
+	}
+
 	gchar * album_name = g_strdup(koto_utils_string_unquote(fields[2]));
 	gchar * album_description = (fields[3] != NULL) ? g_strdup(koto_utils_string_unquote(fields[3])) : NULL;
 	gchar * album_narrator = (fields[4] != NULL) ? g_strdup(koto_utils_string_unquote(fields[4])) : NULL;
@@ -143,15 +239,8 @@ int process_albums(
 
 	koto_cartographer_add_album(koto_maps, album); // Add the album to our global cartographer
 	koto_artist_add_album(artist, album); // Add the album
-
-	int tracks_rc = sqlite3_exec(koto_db, g_strdup_printf("SELECT * FROM tracks WHERE album_id=\"%s\"", album_uuid), process_tracks, NULL, NULL); // Process all the tracks for this specific album
-
-	if (tracks_rc != SQLITE_OK) { // Failed to get our tracks
-		g_critical("Failed to read our tracks: %s", sqlite3_errmsg(koto_db));
-		return 1;
-	}
-
-	koto_album_mark_as_finalized(album); // Mark the album as finalized now that all tracks have been loaded, allowing our internal album playlist to re-sort itself
+	state->albums = g_list_prepend(state->albums, album);
+	state->num_albums++;
 
 	g_free(album_uuid);
 	g_free(artist_uuid);
@@ -171,9 +260,9 @@ int process_playlists(
 	char ** fields,
 	char ** column_names
 ) {
-	(void) data;
-	(void) num_columns;
-	(void) column_names; // Don't need any of the params
+	(void) column_names; // Don't need these
+
+	KotoLoaderState * state = data;
 
 	gchar * playlist_uuid = g_strdup(koto_utils_string_unquote(fields[0])); // First column is UUID
 	gchar * playlist_name = g_strdup(koto_utils_string_unquote(fields[1])); // Second column is playlist name
@@ -182,6 +271,7 @@ int process_playlists(
 	gchar * playlist_album_id = g_strdup(koto_utils_string_unquote(fields[4])); // Fifth column is any album ID
 	gchar * playlist_current_track_id = g_strdup(koto_utils_string_unquote(fields[5])); // Sixth column is any track ID
 	guint64 playlist_track_current_playback_pos = g_ascii_strtoull(koto_utils_string_unquote(fields[6]), NULL, 10); // Seventh column is any playback position for the track
+	guint64 playlist_shuffle_seed = ((num_columns > 7) && (fields[7] != NULL)) ? g_ascii_strtoull(fields[7], NULL, 10) : 0; // Eighth column is any shuffle seed, added by a migration
 
 	KotoPreferredPlaylistSortType sort_type = (KotoPreferredPlaylistSortType) playlist_preferred_sort;
 
@@ -217,30 +307,29 @@ int process_playlists(
 		NULL
 	);
 
-	if (!for_album) { // Isn't for an album
-		int playlist_tracks_rc = sqlite3_exec(koto_db, g_strdup_printf("SELECT * FROM playlist_tracks WHERE playlist_id=\"%s\" ORDER BY position ASC", playlist_uuid), process_playlists_tracks, playlist, NULL); // Process our playlist tracks
-
-		if (playlist_tracks_rc != SQLITE_OK) { // Failed to get our playlist tracks
-			g_critical("Failed to read our playlist tracks: %s", sqlite3_errmsg(koto_db));
-			goto free;
-		}
-	}
+	koto_playlist_set_shuffle_seed(playlist, (guint32) playlist_shuffle_seed); // Restore our shuffled order
 
-	if (koto_utils_string_is_valid(playlist_current_track_id)) { // If we have a track UUID (probably)
-		KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, playlist_current_track_id); // Get the track UUID
+	KotoLoaderPlaylist * pending = g_new0(KotoLoaderPlaylist, 1);
+	pending->uuid = g_strdup(playlist_uuid);
+	pending->current_track_uuid = g_strdup(playlist_current_track_id);
+	pending->current_track_playback_position = playlist_track_current_playback_pos;
+	pending->tracks = g_ptr_array_new();
 
-		if (KOTO_IS_TRACK(track)) { // If this is a track
-			koto_track_set_playback_position(track, playlist_track_current_playback_pos); // Set the playback position of the track
-			koto_playlist_set_track_as_current(playlist, playlist_current_track_id); // Ensure we have this track set as the current one in the playlist
-		}
+	if (for_album) { // Album playlists get their tracks from the album, so they can be finished now
+		koto_loader_finish_playlist(playlist, pending);
+		koto_loader_playlist_free(pending);
+	} else { // Finish once all playlist tracks are loaded
+		g_hash_table_replace(state->playlists, pending->uuid, pending);
 	}
 
-	koto_playlist_mark_as_finalized(playlist); // Mark as finalized since loading should be complete
+	state->num_playlists++;
 
 free:
 	g_free(playlist_uuid);
 	g_free(playlist_name);
 	g_free(playlist_art_path);
+	g_free(playlist_album_id);
+	g_free(playlist_current_track_id);
 
 	return 0;
 }
@@ -251,21 +340,25 @@ int process_playlists_tracks(
 	char ** fields,
 	char ** column_names
 ) {
-	(void) data;
 	(void) num_columns;
 	(void) column_names; // Don't need these
 
+	KotoLoaderState * state = data;
+
 	gchar * playlist_uuid = g_strdup(koto_utils_string_unquote(fields[1]));
 	gchar * track_uuid = g_strdup(koto_utils_string_unquote(fields[2]));
 
-	KotoPlaylist * playlist = koto_cartographer_get_playlist_by_uuid(koto_maps, playlist_uuid); // Get the playlist
-	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, track_uuid); // Get the track
+	KotoLoaderPlaylist * pending = g_hash_table_lookup(state->playlists, playlist_uuid);
 
-	if (!KOTO_IS_PLAYLIST(playlist)) {
+	if (pending == NULL) { // Not a playlist we are loading tracks for, such as one for an album
 		goto freeforret;
 	}
 
-	koto_playlist_add_track(playlist, track, FALSE, FALSE); // Add the track to the playlist but don't re-commit to the table
+	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, track_uuid); // Get the track
+
+	if (KOTO_IS_TRACK(track)) { // Have the track
+		g_ptr_array_add(pending->tracks, track); // Added with the rest once the playlist is finished
+	}
 
 freeforret:
 	g_free(playlist_uuid);
@@ -280,10 +373,11 @@ int process_tracks(
 	char ** fields,
 	char ** column_names
 ) {
-	(void) data;
 	(void) num_columns;
 	(void) column_names; // Don't need these
 
+	KotoLoaderState * state = data;
+
 	gchar * track_uuid = g_strdup(koto_utils_string_unquote(fields[0]));
 
 	KotoTrack * existing_track = koto_cartographer_get_track_by_uuid(koto_maps, track_uuid);
@@ -295,6 +389,17 @@ int process_tracks(
 
 	gchar * artist_uuid = g_strdup(koto_utils_string_unquote(fields[1]));
 	gchar * album_uuid = g_strdup(koto_utils_string_unquote(fields[2]));
+
+	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid); // Get the artist
+	KotoAlbum * album = koto_utils_string_is_valid(album_uuid) ? koto_cartographer_get_album_by_uuid(koto_maps, album_uuid) : NULL; // Attempt to get album
+
+	if (koto_utils_string_is_valid(album_uuid) ? !KOTO_IS_ALBUM(album) : !KOTO_IS_ARTIST(artist)) { // Album or artist this track belongs to no longer exists
+		g_free(track_uuid);
+		g_free(artist_uuid);
+		g_free(album_uuid);
+		return 0;
+	}
+
 	gchar * name = g_strdup(koto_utils_string_unquote(fields[3]));
 	guint * disc_num = (guint*) g_ascii_strtoull(fields[4], NULL, 10);
 	guint64 * position = (guint64*) g_ascii_strtoull(fields[5], NULL, 10);
@@ -324,29 +429,24 @@ int process_tracks(
 
 	g_free(name);
 
-	int track_paths = sqlite3_exec(koto_db, g_strdup_printf("SELECT id, path FROM libraries_tracks WHERE track_id=\"%s\"", track_uuid), process_track_paths, track, NULL); // Process all pathes associated with the track
-
-	if (track_paths != SQLITE_OK) { // Failed to read the paths
-		g_warning("Failed to read paths associated with track %s: %s", track_uuid, sqlite3_errmsg(koto_db));
-		g_free(track_uuid);
-		g_free(artist_uuid);
-		g_free(album_uuid);
-		return 1;
-	}
-
-	koto_cartographer_add_track(koto_maps, track); // Add the track to cartographer if necessary
-
-	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid); // Get the artist
-	koto_artist_add_track(artist, track); // Add the track for the artist
+	GPtrArray * paths = g_hash_table_lookup(state->track_paths, track_uuid); // Get the paths we loaded for this track
 
-	if (koto_utils_string_is_valid(album_uuid)) { // If we have an album UUID
-		KotoAlbum * album = koto_cartographer_get_album_by_uuid(koto_maps, album_uuid); // Attempt to get album
+	for (guint i = 0; (paths != NULL) && (i + 1 < paths->len); i += 2) { // For each library UUID and path pair
+		KotoLibrary * library = koto_cartographer_get_library_by_uuid(koto_maps, g_ptr_array_index(paths, i));
 
-		if (KOTO_IS_ALBUM(album)) { // This is an album
-			koto_album_add_track(album, track); // Add the track
+		if (KOTO_IS_LIBRARY(library)) { // Library still exists
+			koto_track_set_path(track, library, g_ptr_array_index(paths, i + 1));
 		}
 	}
 
+	KotoLoaderTrack * pending = g_new0(KotoLoaderTrack, 1);
+	pending->track = track;
+	pending->artist = artist;
+	pending->album = album;
+	g_ptr_array_add(state->pending_tracks, pending); // Add to the cartographer with the rest of this batch
+
+	state->num_tracks++;
+
 	g_free(track_uuid);
 	g_free(artist_uuid);
 	g_free(album_uuid);
@@ -360,33 +460,363 @@ int process_track_paths(
 	char ** fields,
 	char ** column_names
 ) {
-	KotoTrack * track = (KotoTrack*) data;
 	(void) num_columns;
 	(void) column_names; // Don't need these
 
-	KotoLibrary * library = koto_cartographer_get_library_by_uuid(koto_maps, koto_utils_string_unquote(fields[0]));
+	KotoLoaderState * state = data;
+	koto_loader_add_path(state->track_paths, fields); // Hold onto the path until we create the track
+	return 0;
+}
+
+
+static void koto_loader_flush_tracks(KotoLoaderState * state) {
+	if (state->pending_tracks->len == 0) { // Nothing pending
+		return;
+	}
+
+	GPtrArray * tracks = g_ptr_array_sized_new(state->pending_tracks->len);
 
-	if (!KOTO_IS_LIBRARY(library)) { // Not a library
-		return 1;
+	for (guint i = 0; i < state->pending_tracks->len; i++) { // For each pending track
+		KotoLoaderTrack * pending = g_ptr_array_index(state->pending_tracks, i);
+		g_ptr_array_add(tracks, pending->track);
+	}
+
+	koto_cartographer_add_tracks(koto_maps, tracks); // Add them all under a single lock
+	g_ptr_array_unref(tracks);
+
+	for (guint i = 0; i < state->pending_tracks->len; i++) { // For each pending track
+		KotoLoaderTrack * pending = g_ptr_array_index(state->pending_tracks, i);
+		koto_artist_add_track(pending->artist, pending->track); // Add the track for the artist
+
+		if (KOTO_IS_ALBUM(pending->album)) { // This is an album
+			koto_album_add_track(pending->album, pending->track); // Add the track
+		}
 	}
 
-	koto_track_set_path(track, library, koto_utils_string_unquote(fields[1]));
+	g_ptr_array_set_size(state->pending_tracks, 0); // Frees our KotoLoaderTracks
+}
+
+static void koto_loader_row_free(KotoLoaderRow * row) {
+	for (int i = 0; i < row->num_columns; i++) { // For each column
+		g_free(row->fields[i]);
+	}
+
+	g_free(row->fields);
+	g_free(row);
+}
+
+static int koto_loader_collect_row(
+	void * data,
+	int num_columns,
+	char ** fields,
+	char ** column_names
+) {
+	(void) column_names; // Don't need these
+
+	KotoLoaderRow * row = g_new0(KotoLoaderRow, 1);
+	row->num_columns = num_columns;
+	row->fields = g_new0(gchar*, num_columns + 1);
+
+	for (int i = 0; i < num_columns; i++) { // For each column
+		row->fields[i] = g_strdup(fields[i]); // NULL columns stay NULL
+	}
+
+	g_ptr_array_add((GPtrArray*) data, row);
 	return 0;
 }
 
+static gboolean koto_loader_row_in(
+	GHashTable * uuids,
+	KotoLoaderRow * row,
+	int column
+) {
+	if ((column >= row->num_columns) || (row->fields[column] == NULL)) { // No value for this column
+		return FALSE;
+	}
+
+	gchar * uuid = koto_utils_string_unquote(row->fields[column]);
+	gboolean found = g_hash_table_contains(uuids, uuid);
+	g_free(uuid);
 
-void read_from_db() {
-	int artists_rc = sqlite3_exec(koto_db, "SELECT * FROM artists", process_artists, NULL, NULL); // Process our artists
+	return found;
+}
 
-	if (artists_rc != SQLITE_OK) { // Failed to get our artists
-		g_critical("Failed to read our artists: %s", sqlite3_errmsg(koto_db));
+static void koto_loader_row_add_to(
+	GHashTable * uuids,
+	KotoLoaderRow * row,
+	int column
+) {
+	if ((column >= row->num_columns) || (row->fields[column] == NULL)) { // No value for this column
 		return;
 	}
 
-	int playlist_rc = sqlite3_exec(koto_db, "SELECT * FROM playlist_meta", process_playlists, NULL, NULL); // Process our playlists
+	gchar * uuid = koto_utils_string_unquote(row->fields[column]);
 
-	if (playlist_rc != SQLITE_OK) { // Failed to get our playlists
-		g_critical("Failed to read our playlists: %s", sqlite3_errmsg(koto_db));
+	if (!koto_utils_string_is_valid(uuid)) { // Empty UUID
+		g_free(uuid);
 		return;
 	}
-}
\ No newline at end of file
+
+	g_hash_table_add(uuids, uuid); // Set takes ownership of the UUID
+}
+
+static void koto_loader_prioritize(KotoLoaderState * state) {
+	for (guint i = 0; i < state->playlist_rows->len; i++) { // For each playlist
+		KotoLoaderRow * row = g_ptr_array_index(state->playlist_rows, i);
+		gchar * current_track_uuid = (row->num_columns > 5) ? koto_utils_string_unquote(row->fields[5]) : NULL;
+
+		if (koto_utils_string_is_valid(current_track_uuid)) { // Playlist we were last playing from
+			koto_loader_row_add_to(state->priority_playlists, row, 0);
+			koto_loader_row_add_to(state->priority_albums, row, 4);
+			koto_loader_row_add_to(state->priority_tracks, row, 5);
+		}
+
+		g_free(current_track_uuid);
+	}
+
+	for (guint i = 0; i < state->playlist_track_rows->len; i++) { // For each playlist track
+		KotoLoaderRow * row = g_ptr_array_index(state->playlist_track_rows, i);
+
+		if (koto_loader_row_in(state->priority_playlists, row, 1)) { // Part of a playlist we were last playing from
+			koto_loader_row_add_to(state->priority_tracks, row, 2);
+		}
+	}
+
+	for (guint i = 0; i < state->track_rows->len; i++) { // For each track
+		KotoLoaderRow * row = g_ptr_array_index(state->track_rows, i);
+
+		if (koto_loader_row_in(state->priority_tracks, row, 0)) { // Track needs to load first, so its artist and album do too
+			koto_loader_row_add_to(state->priority_artists, row, 1);
+			koto_loader_row_add_to(state->priority_albums, row, 2);
+		}
+	}
+
+	for (guint i = 0; i < state->album_rows->len; i++) { // For each album
+		KotoLoaderRow * row = g_ptr_array_index(state->album_rows, i);
+
+		if (koto_loader_row_in(state->priority_albums, row, 0)) { // Album needs to load first, so its artist does too
+			koto_loader_row_add_to(state->priority_artists, row, 1);
+		}
+	}
+
+	for (guint i = 0; i < state->track_rows->len; i++) { // For each track
+		KotoLoaderRow * row = g_ptr_array_index(state->track_rows, i);
+
+		if (koto_loader_row_in(state->priority_albums, row, 2)) { // Load the rest of the album alongside the current track so the album can be finalized early
+			koto_loader_row_add_to(state->priority_tracks, row, 0);
+		}
+	}
+}
+
+static void koto_loader_queue_step(
+	KotoLoaderState * state,
+	KotoLoaderStepType type,
+	KotoLoaderRow * row
+) {
+	KotoLoaderStep * step = g_new0(KotoLoaderStep, 1);
+	step->type = type;
+	step->row = row;
+	g_queue_push_tail(state->steps, step);
+}
+
+static void koto_loader_queue_rows(
+	KotoLoaderState * state,
+	GPtrArray * rows,
+	KotoLoaderStepType type,
+	GHashTable * priority_uuids,
+	int column,
+	gboolean priority
+) {
+	for (guint i = 0; i < rows->len; i++) { // For each row
+		KotoLoaderRow * row = g_ptr_array_index(rows, i);
+
+		if (koto_loader_row_in(priority_uuids, row, column) == priority) { // Belongs in this pass
+			koto_loader_queue_step(state, type, row);
+		}
+	}
+}
+
+static void koto_loader_queue_pass(
+	KotoLoaderState * state,
+	gboolean priority
+) {
+	koto_loader_queue_rows(state, state->artist_rows, KOTO_LOADER_STEP_ARTIST, state->priority_artists, 0, priority);
+	koto_loader_queue_rows(state, state->album_rows, KOTO_LOADER_STEP_ALBUM, state->priority_albums, 0, priority);
+	koto_loader_queue_rows(state, state->track_rows, KOTO_LOADER_STEP_TRACK, state->priority_tracks, 0, priority);
+	koto_loader_queue_step(state, KOTO_LOADER_STEP_FINALIZE_ALBUMS, NULL);
+	koto_loader_queue_rows(state, state->playlist_rows, KOTO_LOADER_STEP_PLAYLIST, state->priority_playlists, 0, priority);
+	koto_loader_queue_rows(state, state->playlist_track_rows, KOTO_LOADER_STEP_PLAYLIST_TRACK, state->priority_playlists, 1, priority);
+	koto_loader_queue_step(state, KOTO_LOADER_STEP_FINISH_PLAYLISTS, NULL);
+}
+
+static void koto_loader_state_free(KotoLoaderState * state) {
+	g_hash_table_unref(state->artist_paths);
+	g_hash_table_unref(state->track_paths);
+	g_hash_table_unref(state->playlists);
+	g_hash_table_unref(state->priority_artists);
+	g_hash_table_unref(state->priority_albums);
+	g_hash_table_unref(state->priority_tracks);
+	g_hash_table_unref(state->priority_playlists);
+	g_ptr_array_unref(state->artist_rows);
+	g_ptr_array_unref(state->album_rows);
+	g_ptr_array_unref(state->track_rows);
+	g_ptr_array_unref(state->playlist_rows);
+	g_ptr_array_unref(state->playlist_track_rows);
+	g_queue_free_full(state->steps, g_free);
+	g_ptr_array_unref(state->pending_tracks);
+	g_list_free(state->artists);
+	g_list_free(state->albums);
+	g_free(state);
+}
+
+static void koto_loader_finish(KotoLoaderState * state) {
+	for (GList * cur_list = state->artists; cur_list != NULL; cur_list = cur_list->next) { // For each artist
+		koto_artist_set_as_finalized(KOTO_ARTIST(cur_list->data)); // Indicate it is finalized now that its albums are loaded
+	}
+
+	g_message(
+		"Loaded %u artists, %u albums, %u tracks and %u playlists from the database in %.1fms (%.1fms reading)",
+		state->num_artists,
+		state->num_albums,
+		state->num_tracks,
+		state->num_playlists,
+		(g_get_monotonic_time() - state->start_time) / 1000.0,
+		state->read_time / 1000.0
+	);
+
+	koto_window_set_loading(main_window, FALSE); // Library is fully loaded
+	koto_loader_state_free(state);
+	koto_config_reconcile_libs(config); // Now that we know what was indexed before, catch up on anything that changed while we were closed
+}
+
+static gboolean koto_loader_process_steps(gpointer user_data) {
+	KotoLoaderState * state = user_data;
+
+	for (guint i = 0; i < KOTO_LOADER_STEPS_PER_IDLE; i++) { // Only do a bounded amount of work before yielding back to the main loop
+		KotoLoaderStep * step = g_queue_pop_head(state->steps);
+
+		if (step == NULL) { // Nothing left to load
+			koto_loader_flush_tracks(state);
+			koto_loader_finish(state);
+			return G_SOURCE_REMOVE;
+		}
+
+		KotoLoaderRow * row = step->row;
+
+		if (step->type != KOTO_LOADER_STEP_TRACK) { // Everything else may need the tracks we created
+			koto_loader_flush_tracks(state);
+		}
+
+		switch (step->type) {
+			case KOTO_LOADER_STEP_ARTIST:
+				process_artists(state, row->num_columns, row->fields, NULL);
+				break;
+			case KOTO_LOADER_STEP_ALBUM:
+				process_albums(state, row->num_columns, row->fields, NULL);
+				break;
+			case KOTO_LOADER_STEP_TRACK:
+				process_tracks(state, row->num_columns, row->fields, NULL);
+				break;
+			case KOTO_LOADER_STEP_FINALIZE_ALBUMS:
+				for (GList * cur_list = state->albums; cur_list != NULL; cur_list = cur_list->next) { // For each album loaded in this pass
+					koto_album_mark_as_finalized(KOTO_ALBUM(cur_list->data)); // Mark the album as finalized now that all tracks have been loaded, allowing our internal album playlist to re-sort itself
+				}
+
+				g_list_free(state->albums);
+				state->albums = NULL;
+				break;
+			case KOTO_LOADER_STEP_PLAYLIST:
+				process_playlists(state, row->num_columns, row->fields, NULL);
+				break;
+			case KOTO_LOADER_STEP_PLAYLIST_TRACK:
+				process_playlists_tracks(state, row->num_columns, row->fields, NULL);
+				break;
+			case KOTO_LOADER_STEP_FINISH_PLAYLISTS: {
+				GHashTableIter iter;
+				gpointer playlist_uuid, pending;
+
+				g_hash_table_iter_init(&iter, state->playlists);
+
+				while (g_hash_table_iter_next(&iter, &playlist_uuid, &pending)) { // For each playlist loaded in this pass that now has its tracks
+					koto_loader_finish_playlist(koto_cartographer_get_playlist_by_uuid(koto_maps, playlist_uuid), pending);
+				}
+
+				g_hash_table_remove_all(state->playlists);
+				break;
+			}
+		}
+
+		g_free(step);
+	}
+
+	koto_loader_flush_tracks(state);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean koto_loader_exec(
+	gpointer data,
+	const gchar * query,
+	sqlite3_callback callback,
+	const gchar * what
+) {
+	sqlite3 * reader = koto_db_get_reader(); // Our own connection, so loading never waits on writes
+	int rc = sqlite3_exec(reader, query, callback, data, NULL);
+
+	if (rc != SQLITE_OK) { // Failed to read
+		g_critical("Failed to read our %s: %s", what, sqlite3_errmsg(reader));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gpointer koto_loader_read_thread(gpointer user_data) {
+	KotoLoaderState * state = user_data;
+	gint64 read_start = g_get_monotonic_time();
+
+	(void) ( // Stop reading at the first table that fails, whatever was read is still loaded
+		koto_loader_exec(state, "SELECT id, artist_id, path FROM libraries_artists ORDER BY artist_id", process_artist_paths, "artist paths") &&
+		koto_loader_exec(state->artist_rows, "SELECT * FROM artists", koto_loader_collect_row, "artists") &&
+		koto_loader_exec(state->album_rows, "SELECT * FROM albums ORDER BY artist_id", koto_loader_collect_row, "albums") &&
+		koto_loader_exec(state, "SELECT id, track_id, path FROM libraries_tracks ORDER BY track_id", process_track_paths, "track paths") &&
+		koto_loader_exec(state->track_rows, "SELECT * FROM tracks ORDER BY artist_id, album_id", koto_loader_collect_row, "tracks") &&
+		koto_loader_exec(state->playlist_rows, "SELECT * FROM playlist_meta", koto_loader_collect_row, "playlists") &&
+		koto_loader_exec(state->playlist_track_rows, "SELECT * FROM playlist_tracks ORDER BY playlist_id, position ASC", koto_loader_collect_row, "playlist tracks")
+	);
+
+	koto_loader_prioritize(state); // Figure out what we were last playing so it can be loaded before everything else
+	koto_loader_queue_pass(state, TRUE);
+	koto_loader_queue_pass(state, FALSE);
+
+	state->read_time = g_get_monotonic_time() - read_start;
+
+	g_idle_add(koto_loader_process_steps, state); // Create our objects on the main thread, a batch at a time
+	return NULL;
+}
+
+/**
+ * Load our library and playlists without blocking the main loop.
+ * Each table is read with a single ordered scan in a separate thread, then the objects are created on the main thread in bounded batches from an idle callback, starting with the playlist and track we were last playing.
+ **/
+void read_from_db() {
+	KotoLoaderState * state = g_new0(KotoLoaderState, 1);
+
+	state->artist_paths = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	state->track_paths = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	state->playlists = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, (GDestroyNotify) koto_loader_playlist_free);
+	state->priority_artists = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	state->priority_albums = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	state->priority_tracks = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	state->priority_playlists = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	state->artist_rows = g_ptr_array_new_with_free_func((GDestroyNotify) koto_loader_row_free);
+	state->album_rows = g_ptr_array_new_with_free_func((GDestroyNotify) koto_loader_row_free);
+	state->track_rows = g_ptr_array_new_with_free_func((GDestroyNotify) koto_loader_row_free);
+	state->playlist_rows = g_ptr_array_new_with_free_func((GDestroyNotify) koto_loader_row_free);
+	state->playlist_track_rows = g_ptr_array_new_with_free_func((GDestroyNotify) koto_loader_row_free);
+	state->steps = g_queue_new();
+	state->pending_tracks = g_ptr_array_new_with_free_func(g_free);
+	state->start_time = g_get_monotonic_time();
+
+	koto_window_set_loading(main_window, TRUE); // Show that we are still loading until the last batch is done
+	g_thread_unref(g_thread_new("loading-library-from-db", koto_loader_read_thread, state)); // Never joined, so drop our ref and let it clean up once done
+}
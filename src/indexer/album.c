@@ -25,11 +25,11 @@
 #include "../playlist/playlist.h"
 #include "../koto-utils.h"
 #include "album-playlist-funcs.h"
+#include "mime-helpers.h"
 #include "track-helpers.h"
 
 extern KotoCartographer * koto_maps;
 extern KotoCurrentPlaylist * current_playlist;
-extern magic_t magic_cookie;
 extern sqlite3 * koto_db;
 
 enum {
@@ -65,6 +65,7 @@ struct _KotoAlbum {
 	gchar * uuid;
 
 	gchar * name;
+	gchar * name_collation_key; // Precomputed so sorting by album does not collate on every comparison
 	guint64 year;
 	gchar * description;
 	gchar * narrator;
@@ -305,43 +306,32 @@ void koto_album_commit(KotoAlbum * self) {
 		koto_album_set_album_art(self, ""); // Set to an empty string
 	}
 
-	gchar * genres_string = koto_utils_join_string_list(self->genres, ";");
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_ALBUM);
 
-	gchar * commit_op = g_strdup_printf(
-		"INSERT INTO albums(id, artist_id, name, description, narrator, art_path, genres, year)"
-		"VALUES('%s', '%s', quote(\"%s\"), quote(\"%s\"), quote(\"%s\"), quote(\"%s\"), '%s', %ld)"
-		"ON CONFLICT(id) DO UPDATE SET artist_id=excluded.artist_id, name=excluded.name, description=excluded.description, narrator=excluded.narrator, art_path=excluded.art_path, genres=excluded.genres, year=excluded.year;",
-		self->uuid,
-		self->artist_uuid,
-		koto_utils_string_get_valid(self->name),
-		koto_utils_string_get_valid(self->description),
-		koto_utils_string_get_valid(self->narrator),
-		koto_utils_string_get_valid(self->art_path),
-		koto_utils_string_get_valid(genres_string),
-		self->year
-	);
+	gchar * genres_string = koto_utils_join_string_list(self->genres, ";");
 
-	new_transaction(commit_op, "Failed to write our album to the database", FALSE);
+	koto_db_write_bind_text(write, 1, self->uuid);
+	koto_db_write_bind_text(write, 2, self->artist_uuid);
+	koto_db_write_bind_text(write, 3, koto_utils_string_get_valid(self->name));
+	koto_db_write_bind_text(write, 4, koto_utils_string_get_valid(self->description));
+	koto_db_write_bind_text(write, 5, koto_utils_string_get_valid(self->narrator));
+	koto_db_write_bind_text(write, 6, koto_utils_string_get_valid(self->art_path));
+	koto_db_write_bind_text(write, 7, koto_utils_string_get_valid(genres_string));
+	koto_db_write_bind_int64(write, 8, self->year);
 
+	koto_db_writer_push(write, "Failed to write our album to the database");
 	g_free(genres_string);
 
 	GHashTableIter paths_iter;
 	g_hash_table_iter_init(&paths_iter, self->paths); // Create an iterator for our paths
 	gpointer lib_uuid_ptr, album_rel_path_ptr;
 	while (g_hash_table_iter_next(&paths_iter, &lib_uuid_ptr, &album_rel_path_ptr)) {
-		gchar * lib_uuid = lib_uuid_ptr;
-		gchar * album_rel_path = album_rel_path_ptr;
+		KotoDbWrite * path_write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_ALBUM_PATH);
 
-		gchar * commit_op = g_strdup_printf(
-			"INSERT INTO libraries_albums(id, album_id, path)"
-			"VALUES ('%s', '%s', quote(\"%s\"))"
-			"ON CONFLICT(id, album_id) DO UPDATE SET path=excluded.path;",
-			lib_uuid,
-			self->uuid,
-			album_rel_path
-		);
-
-		new_transaction(commit_op, "Failed to add this path for the album", FALSE);
+		koto_db_write_bind_text(path_write, 1, lib_uuid_ptr);
+		koto_db_write_bind_text(path_write, 2, self->uuid);
+		koto_db_write_bind_text(path_write, 3, album_rel_path_ptr);
+		koto_db_writer_push(path_write, "Failed to add this path for the album");
 	}
 }
 
@@ -370,7 +360,7 @@ void koto_album_find_album_art(KotoAlbum * self) {
 
 		gchar * full_path = g_strdup_printf("%s%s%s", optimal_album_path, G_DIR_SEPARATOR_S, entry->d_name);
 
-		const char * mime_type = magic_file(magic_cookie, full_path);
+		const char * mime_type = koto_mime_helpers_get_mimetype_for_file(full_path, koto_mime_helpers_get_magic_cookie()); // Albums are also set up by the indexing threads
 
 		if (
 			(mime_type == NULL) || // Failed to get the mimetype
@@ -501,6 +491,14 @@ KotoLibraryType koto_album_get_lib_type(KotoAlbum * self) {
 	return koto_artist_get_lib_type(koto_cartographer_get_artist_by_uuid(koto_maps, self->artist_uuid)); // Get the lib type for the artist. If artist isn't valid, we just return UNKNOWN
 }
 
+const gchar * koto_album_get_name_collation_key(KotoAlbum * self) {
+	if (!KOTO_IS_ALBUM(self) || (self->name_collation_key == NULL)) { // Not an album or no name yet
+		return "";
+	}
+
+	return self->name_collation_key;
+}
+
 gchar * koto_album_get_name(KotoAlbum * self) {
 	if (!KOTO_IS_ALBUM(self)) { // Not an album
 		return NULL;
@@ -551,16 +549,6 @@ KotoPlaylist * koto_album_get_playlist(KotoAlbum * self) {
 	return self->playlist;
 }
 
-GListStore * koto_album_get_store(KotoAlbum * self) {
-	KotoPlaylist * playlist = koto_album_get_playlist(self);
-
-	if (!KOTO_IS_PLAYLIST(playlist)) { // Not a playlist
-		return NULL;
-	}
-
-	return koto_playlist_get_store(playlist); // Return the store from the playlist
-}
-
 gchar * koto_album_get_uuid(KotoAlbum * self) {
 	if (!KOTO_IS_ALBUM(self)) { // Not an album
 		return NULL;
@@ -629,6 +617,9 @@ void koto_album_set_album_name(
 	}
 
 	self->name = g_strdup(album_name);
+
+	g_free(self->name_collation_key);
+	self->name_collation_key = g_utf8_collate_key(album_name, -1); // Rebuild our collation key for the new name
 	g_object_notify_by_pspec(G_OBJECT(self), props[PROP_NAME]);
 }
 
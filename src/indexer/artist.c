@@ -17,6 +17,7 @@
 
 #include <glib-2.0/glib.h>
 #include <sqlite3.h>
+#include <string.h>
 #include "../config/config.h"
 #include "../db/db.h"
 #include "../db/cartographer.h"
@@ -62,6 +63,7 @@ struct _KotoArtist {
 	gboolean finalized;
 	gboolean has_artist_art;
 	gchar * artist_name;
+	gchar * artist_name_collation_key; // Precomputed so sorting by artist does not collate on every comparison
 	GList * tracks;
 	GHashTable * paths;
 	KotoLibraryType type;
@@ -218,38 +220,27 @@ static void koto_artist_init(KotoArtist * self) {
 }
 
 void koto_artist_commit(KotoArtist * self) {
-	if ((self->uuid == NULL) || strcmp(self->uuid, "")) { // UUID not set
+	if (!koto_utils_string_is_valid(self->uuid)) { // UUID not set
 		self->uuid = g_strdup(g_uuid_string_random());
 	}
 
-	// TODO: Support multiple types instead of just local music artist
-	gchar * commit_op = g_strdup_printf(
-		"INSERT INTO artists(id , name, art_path)"
-		"VALUES ('%s', quote(\"%s\"), NULL)"
-		"ON CONFLICT(id) DO UPDATE SET name=excluded.name, art_path=excluded.art_path;",
-		self->uuid,
-		koto_utils_string_get_valid(self->artist_name)
-	);
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_ARTIST);
 
-	new_transaction(commit_op, "Failed to write our artist to the database", FALSE);
+	// TODO: Support multiple types instead of just local music artist
+	koto_db_write_bind_text(write, 1, self->uuid);
+	koto_db_write_bind_text(write, 2, koto_utils_string_get_valid(self->artist_name));
+	koto_db_writer_push(write, "Failed to write our artist to the database");
 
 	GHashTableIter paths_iter;
 	g_hash_table_iter_init(&paths_iter, self->paths); // Create an iterator for our paths
 	gpointer lib_uuid_ptr, artist_rel_path_ptr;
 	while (g_hash_table_iter_next(&paths_iter, &lib_uuid_ptr, &artist_rel_path_ptr)) {
-		gchar * lib_uuid = lib_uuid_ptr;
-		gchar * artist_rel_path = artist_rel_path_ptr;
+		KotoDbWrite * path_write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_ARTIST_PATH);
 
-		gchar * commit_op = g_strdup_printf(
-			"INSERT INTO libraries_artists(id, artist_id, path)"
-			"VALUES ('%s', '%s', quote(\"%s\"))"
-			"ON CONFLICT(id, artist_id) DO UPDATE SET path=excluded.path;",
-			lib_uuid,
-			self->uuid,
-			artist_rel_path
-		);
-
-		new_transaction(commit_op, "Failed to add this path for the artist", FALSE);
+		koto_db_write_bind_text(path_write, 1, lib_uuid_ptr);
+		koto_db_write_bind_text(path_write, 2, self->uuid);
+		koto_db_write_bind_text(path_write, 3, artist_rel_path_ptr);
+		koto_db_writer_push(path_write, "Failed to add this path for the artist");
 	}
 }
 
@@ -426,6 +417,14 @@ gchar * koto_artist_get_name(KotoArtist * self) {
 	return g_strdup(koto_utils_string_is_valid(self->artist_name) ? self->artist_name : ""); // Return artist name if set
 }
 
+const gchar * koto_artist_get_name_collation_key(KotoArtist * self) {
+	if (!KOTO_IS_ARTIST(self) || (self->artist_name_collation_key == NULL)) { // Not an artist or no name yet
+		return "";
+	}
+
+	return self->artist_name_collation_key;
+}
+
 KotoPlaylist * koto_artist_get_playlist(KotoArtist * self) {
 	if (!KOTO_IS_ARTIST(self)) {
 		return NULL;
@@ -515,6 +514,9 @@ void koto_artist_set_artist_name(
 	}
 
 	self->artist_name = g_strdup(artist_name);
+
+	g_free(self->artist_name_collation_key);
+	self->artist_name_collation_key = g_utf8_collate_key(artist_name, -1); // Rebuild our collation key for the new name
 	g_object_notify_by_pspec(G_OBJECT(self), props[PROP_ARTIST_NAME]);
 }
 
@@ -569,7 +571,7 @@ gint koto_artist_model_sort_albums(
 		return 1;
 	}
 
-	if (preferred_model == KOTO_PREFERRED_ALBUM_SORT_TYPE_DEFAULT) { // Sort chronological before alphabetical
+	if (*preferred_model == KOTO_PREFERRED_ALBUM_SORT_TYPE_DEFAULT) { // Sort chronological before alphabetical
 		guint64 fa_year = koto_album_get_year(first_album);
 		guint64 sa_year = koto_album_get_year(second_album);
 
@@ -580,7 +582,7 @@ gint koto_artist_model_sort_albums(
 		}
 	}
 
-	return g_utf8_collate(koto_album_get_name(first_album), koto_album_get_name(second_album));
+	return strcmp(koto_album_get_name_collation_key(first_album), koto_album_get_name_collation_key(second_album));
 }
 
 KotoArtist * koto_artist_new(gchar * artist_name) {
@@ -17,20 +17,480 @@
 
 #include <dirent.h>
 #include <magic.h>
+#include <sqlite3.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
+#include "../config/config.h"
 #include "../db/cartographer.h"
+#include "../db/db.h"
 #include "../koto-utils.h"
+#include "mime-helpers.h"
 #include "structs.h"
 #include "track-helpers.h"
 
+#define KOTO_INDEXER_STEPS_PER_IDLE 50 // Bounded amount of scanned changes to apply before yielding back to the main loop
+
 extern KotoCartographer * koto_maps;
-extern magic_t magic_cookie;
+extern KotoConfig * config;
+
+typedef struct {
+	gint64 mtime;
+	gint64 size;
+	guint64 inode;
+} KotoFileFingerprint;
+
+typedef struct {
+	KotoLibrary * lib;
+	gchar * path;
+	gchar * relative_path;
+	KotoFileFingerprint fingerprint;
+	gchar * artist_name;
+	gchar * album_name;
+	gchar * file_name;
+	guint cd;
+	KotoTrackMetadata * metadata; // Tags read in our single pass over the file
+	gboolean probed; // Whether we successfully determined the mimetype of the file
+	gboolean is_audio;
+} KotoIndexedFile;
+
+typedef struct {
+	KotoLibrary * lib;
+	GHashTable * fingerprints; // Relative paths to the KotoFileFingerprint recorded during the last index of this library
+	guint skipped; // Number of files skipped because their fingerprint is unchanged
+	GThreadPool * pool; // Pool of workers probing and parsing files, NULL when indexing serially
+	GAsyncQueue * results; // Queue of KotoIndexedFile handed back by our workers
+	guint pending; // Number of files handed to the pool that have not been merged yet
+	GList * albums; // Albums to commit once all of their tracks have been merged
+	GList * artists; // Artists to finalize once all of their tracks have been merged
+	guint mime_tier_counts[KOTO_MIME_TIER_COUNT]; // Snapshot of the MIME classifier tier counts when we started
+} KotoIndexerContext;
+
+typedef enum {
+	KOTO_INDEXER_STEP_REMOVE,
+	KOTO_INDEXER_STEP_ARTIST,
+	KOTO_INDEXER_STEP_ALBUM,
+	KOTO_INDEXER_STEP_FILE
+} KotoIndexerStepType;
+
+typedef struct {
+	KotoIndexerStepType type;
+	gchar * relative_path; // Path to remove for KOTO_INDEXER_STEP_REMOVE
+	GPtrArray * track_uuids; // Tracks that were recorded under the removed path
+	gchar * artist_name;
+	gchar * album_name;
+	gchar * full_path; // Directory of the artist or album
+	KotoIndexedFile * indexed_file; // Parsed file to merge for KOTO_INDEXER_STEP_FILE
+} KotoIndexerStep;
+
+struct _KotoIndexerChanges {
+	KotoLibrary * lib;
+	GQueue * removals; // KotoIndexerSteps removing paths, applied before everything else so replaced files are re-indexed cleanly
+	GQueue * steps; // KotoIndexerSteps adding artists, albums and files, in the order we walked them
+	KotoIndexerStep * pending_artist; // Artist we are walking, only queued once something under it changed
+	KotoIndexerStep * pending_album; // Album we are walking, only queued once something under it changed
+	guint skipped; // Number of files skipped because their fingerprint is unchanged
+	GList * albums; // Albums to commit once all of their tracks have been merged
+	GList * artists; // Artists to finalize once all of their tracks have been merged
+	GSourceFunc done;
+	gpointer done_data;
+};
+
+static void index_folder_walk(
+	KotoIndexerContext * ctx,
+	gchar * path,
+	guint depth
+);
+
+static KotoArtist * index_artist_directory(
+	KotoIndexerContext * ctx,
+	gchar * artist_name,
+	gchar * full_path
+);
+
+static void index_album_directory(
+	KotoIndexerContext * ctx,
+	KotoArtist * artist,
+	gchar * album_name,
+	gchar * full_path
+);
+
+static KotoIndexedFile * index_file_new(
+	KotoLibrary * lib,
+	const gchar * path,
+	struct stat * file_stat
+);
+
+static void index_file_parse(
+	KotoIndexedFile * indexed_file,
+	magic_t cookie
+);
+
+static gchar * index_file_merge(KotoIndexedFile * indexed_file);
+
+static void index_file_commit_fingerprint(
+	KotoIndexedFile * indexed_file,
+	const gchar * track_uuid
+);
+
+static void index_file_free(KotoIndexedFile * indexed_file);
+
+/**
+ * Load the fingerprints recorded for the library, or only for the files at or under relative_path when it is set.
+ **/
+static GHashTable * index_load_fingerprints(
+	KotoLibrary * lib,
+	const gchar * relative_path
+) {
+	GHashTable * fingerprints = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+	const gchar * query = (relative_path != NULL) ? "SELECT path, mtime, size, inode FROM files WHERE " KOTO_DB_FILES_UNDER_PATH : "SELECT path, mtime, size, inode FROM files WHERE library_id=?1";
+	sqlite3 * reader = koto_db_get_reader();
+	sqlite3_stmt * stmt = NULL;
+
+	if (sqlite3_prepare_v2(reader, query, -1, &stmt, NULL) != SQLITE_OK) { // Failed to prepare
+		g_warning("Failed to read file fingerprints, indexing every file: %s", sqlite3_errmsg(reader));
+		sqlite3_finalize(stmt);
+		return fingerprints;
+	}
+
+	sqlite3_bind_text(stmt, 1, koto_library_get_uuid(lib), -1, SQLITE_STATIC);
+
+	if (relative_path != NULL) { // Only want this subtree
+		sqlite3_bind_text(stmt, 2, relative_path, -1, SQLITE_STATIC);
+	}
+
+	while (sqlite3_step(stmt) == SQLITE_ROW) { // For each file we have a fingerprint for
+		KotoFileFingerprint * fingerprint = g_new0(KotoFileFingerprint, 1);
+		fingerprint->mtime = sqlite3_column_int64(stmt, 1);
+		fingerprint->size = sqlite3_column_int64(stmt, 2);
+		fingerprint->inode = (guint64) sqlite3_column_int64(stmt, 3);
+
+		g_hash_table_replace(fingerprints, koto_utils_string_unquote((gchar*) sqlite3_column_text(stmt, 0)), fingerprint);
+	}
+
+	sqlite3_finalize(stmt);
+	return fingerprints;
+}
+
+static gboolean index_file_is_unchanged(
+	KotoIndexedFile * indexed_file,
+	KotoFileFingerprint * existing_fingerprint
+) {
+	return (existing_fingerprint != NULL) &&
+		   (existing_fingerprint->mtime == indexed_file->fingerprint.mtime) &&
+		   (existing_fingerprint->size == indexed_file->fingerprint.size) &&
+		   (existing_fingerprint->inode == indexed_file->fingerprint.inode);
+}
+
+static void index_context_begin(KotoIndexerContext * ctx) {
+	koto_mime_helpers_get_tier_counts(ctx->mime_tier_counts); // Snapshot so we only log what this index classified
+	koto_db_writer_begin_batch(koto_config_get_indexer_batch_size(config)); // Group our writes into larger transactions
+}
+
+static void index_context_free(KotoIndexerContext * ctx) {
+	koto_db_writer_end_batch(); // Let the writer go back to smaller transactions
+
+	if (ctx->skipped > 0) { // Skipped some files
+		g_message("Skipped %u unchanged files while indexing %s", ctx->skipped, koto_library_get_path(ctx->lib));
+	}
+
+	gchar * mime_context = g_strdup_printf("indexing %s", koto_library_get_path(ctx->lib));
+	koto_mime_helpers_log_tier_counts(mime_context, ctx->mime_tier_counts); // Log how often we had to fall back to libmagic
+	g_free(mime_context);
+
+	g_hash_table_unref(ctx->fingerprints);
+	g_list_free(ctx->albums);
+	g_list_free(ctx->artists);
+}
+
+static void index_worker_func(
+	gpointer data,
+	gpointer user_data
+) {
+	KotoIndexedFile * indexed_file = data;
+	KotoIndexerContext * ctx = user_data;
+
+	index_file_parse(indexed_file, koto_mime_helpers_get_magic_cookie()); // Probe and parse the file
+	g_async_queue_push(ctx->results, indexed_file); // Always hand back the record so the merger can account for this file
+}
+
+static void index_merge_result(KotoIndexedFile * indexed_file) {
+	gchar * track_uuid = NULL;
+
+	if (indexed_file->is_audio) { // Is an audio file we parsed
+		track_uuid = index_file_merge(indexed_file);
+	}
+
+	if (indexed_file->probed && (!indexed_file->is_audio || koto_utils_string_is_valid(track_uuid))) { // Know what this file is and have fully handled it
+		index_file_commit_fingerprint(indexed_file, track_uuid); // Record the fingerprint so it can be skipped next time if unchanged
+	}
+
+	index_file_free(indexed_file);
+}
+
+static void index_merge_ready_results(KotoIndexerContext * ctx) {
+	KotoIndexedFile * indexed_file;
+
+	while ((indexed_file = g_async_queue_try_pop(ctx->results)) != NULL) { // While we have results ready to merge
+		ctx->pending--;
+		index_merge_result(indexed_file);
+	}
+}
+
+static void index_handle_file(
+	KotoIndexerContext * ctx,
+	gchar * full_path
+) {
+	struct stat file_stat;
+
+	if (stat(full_path, &file_stat) != 0) { // Failed to stat the file
+		return;
+	}
+
+	KotoIndexedFile * indexed_file = index_file_new(ctx->lib, full_path, &file_stat);
+
+	if (index_file_is_unchanged(indexed_file, g_hash_table_lookup(ctx->fingerprints, indexed_file->relative_path))) { // File is unchanged since we last indexed it
+		ctx->skipped++;
+		index_file_free(indexed_file);
+		return;
+	}
+
+	if (ctx->pool != NULL) { // Have workers
+		ctx->pending++;
+		g_thread_pool_push(ctx->pool, indexed_file, NULL); // Hand the file off to be probed and parsed
+		return;
+	}
+
+	index_file_parse(indexed_file, koto_mime_helpers_get_magic_cookie()); // Index this audio file or weird ogg thing
+	index_merge_result(indexed_file);
+}
 
 void index_folder(
 	KotoLibrary * self,
 	gchar * path,
 	guint depth
+) {
+	KotoIndexerContext ctx = {
+		.lib = self,
+		.fingerprints = index_load_fingerprints(self, NULL),
+		.skipped = 0,
+		.pool = NULL,
+		.results = NULL,
+		.pending = 0,
+		.albums = NULL,
+		.artists = NULL,
+	};
+
+	index_context_begin(&ctx);
+
+	index_folder_walk(&ctx, path, depth);
+	index_context_free(&ctx);
+}
+
+void index_folder_parallel(
+	KotoLibrary * self,
+	gchar * path,
+	guint workers
+) {
+	KotoIndexerContext ctx = {
+		.lib = self,
+		.fingerprints = NULL,
+		.skipped = 0,
+		.pool = NULL,
+		.results = g_async_queue_new(),
+		.pending = 0,
+		.albums = NULL,
+		.artists = NULL,
+	};
+
+	GError * pool_err = NULL;
+	ctx.pool = g_thread_pool_new(index_worker_func, &ctx, (gint) workers, FALSE, &pool_err);
+
+	if (pool_err != NULL) { // Failed to create our pool
+		g_warning("Failed to create indexer worker pool, indexing serially: %s", pool_err->message);
+		g_error_free(pool_err);
+		g_async_queue_unref(ctx.results);
+		index_folder(self, path, 0); // Begins and ends its own batch
+		return;
+	}
+
+	index_context_begin(&ctx); // Only once we know we will reach index_context_free
+	ctx.fingerprints = index_load_fingerprints(self, NULL);
+	index_folder_walk(&ctx, path, 0); // Walk the library, handing files to our workers
+
+	while (ctx.pending > 0) { // Still have files being probed and parsed
+		ctx.pending--;
+		index_merge_result(g_async_queue_pop(ctx.results)); // Wait for the next result and merge it
+	}
+
+	g_thread_pool_free(ctx.pool, FALSE, TRUE); // Workers are idle at this point, wait for them to exit
+	g_async_queue_unref(ctx.results);
+
+	GList * cur_list;
+
+	for (cur_list = ctx.albums; cur_list != NULL; cur_list = cur_list->next) { // For each album we deferred
+		koto_album_commit(KOTO_ALBUM(cur_list->data)); // Save now that all of its tracks have been merged
+	}
+
+	for (cur_list = ctx.artists; cur_list != NULL; cur_list = cur_list->next) { // For each artist we deferred
+		koto_artist_set_as_finalized(KOTO_ARTIST(cur_list->data)); // Indicate it is finalized
+	}
+
+	index_context_free(&ctx);
+}
+
+static void index_remove_track(KotoTrack * track) {
+	gchar * artist_uuid = NULL;
+	gchar * album_uuid = NULL;
+
+	g_object_get(track, "artist-uuid", &artist_uuid, "album-uuid", &album_uuid, NULL);
+
+	KotoAlbum * album = koto_cartographer_get_album_by_uuid(koto_maps, album_uuid);
+
+	if (KOTO_IS_ALBUM(album)) { // Track is in an album
+		koto_album_remove_track(album, track);
+	}
+
+	koto_artist_remove_track(koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid), track);
+
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_DELETE_TRACK);
+	koto_db_write_bind_text(write, 1, koto_track_get_uuid(track));
+	koto_db_writer_push(write, "Failed to remove track from the database");
+
+	koto_cartographer_remove_track(koto_maps, track);
+
+	g_free(artist_uuid);
+	g_free(album_uuid);
+}
+
+/**
+ * Remove everything at or under relative_path, given the tracks that were recorded under it. Must only be called from the main thread.
+ **/
+static void index_remove_path(
+	KotoLibrary * self,
+	const gchar * relative_path,
+	GPtrArray * track_uuids
+) {
+	for (guint i = 0; i < track_uuids->len; i++) { // For each track that was under this path
+		KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, g_ptr_array_index(track_uuids, i));
+
+		if (KOTO_IS_TRACK(track)) { // Have this track
+			index_remove_track(track);
+		}
+	}
+
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_DELETE_FILES); // Also covers files that are not tracks
+	koto_db_write_bind_text(write, 1, koto_library_get_uuid(self));
+	koto_db_write_bind_text(write, 2, relative_path);
+	koto_db_writer_push(write, "Failed to remove file fingerprints");
+
+	gchar ** split = g_strsplit(relative_path, G_DIR_SEPARATOR_S, -1); // Determine if this was an artist or album directory
+	guint split_len = g_strv_length(split);
+	KotoArtist * artist = (split_len > 0) ? koto_cartographer_get_artist_by_name(koto_maps, split[0]) : NULL;
+
+	if (KOTO_IS_ARTIST(artist) && (split_len == 1)) { // Artist directory was removed
+		KotoDbWrite * artist_write = koto_db_writer_new_write(KOTO_DB_STATEMENT_DELETE_ARTIST);
+		koto_db_write_bind_text(artist_write, 1, koto_artist_get_uuid(artist));
+		koto_db_writer_push(artist_write, "Failed to remove artist from the database");
+		koto_cartographer_remove_artist(koto_maps, artist);
+	} else if (KOTO_IS_ARTIST(artist) && (split_len == 2)) { // Possibly an album directory was removed
+		KotoAlbum * album = koto_artist_get_album_by_name(artist, split[1]);
+
+		if (KOTO_IS_ALBUM(album)) { // Was an album
+			KotoDbWrite * album_write = koto_db_writer_new_write(KOTO_DB_STATEMENT_DELETE_ALBUM);
+			koto_db_write_bind_text(album_write, 1, koto_album_get_uuid(album));
+			koto_db_writer_push(album_write, "Failed to remove album from the database");
+			koto_artist_remove_album(artist, album);
+			koto_cartographer_remove_album(koto_maps, album);
+		}
+	}
+
+	g_strfreev(split);
+}
+
+static KotoArtist * index_add_artist(
+	KotoLibrary * lib,
+	gchar * artist_name,
+	gchar * full_path
+) {
+	KotoArtist * artist = koto_cartographer_get_artist_by_name(koto_maps, artist_name); // Attempt to get any existing artist, such as when re-indexing
+
+	if (!KOTO_IS_ARTIST(artist)) { // Don't have this artist yet
+		artist = koto_artist_new(artist_name); // Attempt to create the artist
+	}
+
+	if (!KOTO_IS_ARTIST(artist)) { // Failed to create the artist
+		return NULL;
+	}
+
+	koto_artist_set_path(artist, lib, full_path, TRUE); // Add the path for this library on this Artist and commit immediately
+	koto_cartographer_add_artist(koto_maps, artist); // Add the artist to cartographer
+	return artist;
+}
+
+static KotoAlbum * index_add_album(
+	KotoLibrary * lib,
+	KotoArtist * artist,
+	gchar * album_name,
+	gchar * full_path
+) {
+	KotoAlbum * album = koto_artist_get_album_by_name(artist, album_name); // Attempt to get any existing album, such as when re-indexing
+
+	if (!KOTO_IS_ALBUM(album)) { // Don't have this album yet
+		album = koto_album_new(koto_artist_get_uuid(artist));
+	}
+
+	koto_album_set_path(album, lib, full_path);
+
+	koto_cartographer_add_album(koto_maps, album); // Add our album to the cartographer
+	koto_artist_add_album(artist, album); // Add the album
+	return album;
+}
+
+static KotoArtist * index_artist_directory(
+	KotoIndexerContext * ctx,
+	gchar * artist_name,
+	gchar * full_path
+) {
+	KotoArtist * artist = index_add_artist(ctx->lib, artist_name, full_path);
+
+	if (!KOTO_IS_ARTIST(artist)) { // Failed to create the artist
+		return NULL;
+	}
+
+	index_folder_walk(ctx, full_path, 1); // Index this directory
+
+	if (ctx->pool != NULL) { // Tracks may still be in flight
+		ctx->artists = g_list_prepend(ctx->artists, artist); // Finalize once everything has been merged
+	} else {
+		koto_artist_set_as_finalized(artist); // Indicate it is finalized
+	}
+
+	return artist;
+}
+
+static void index_album_directory(
+	KotoIndexerContext * ctx,
+	KotoArtist * artist,
+	gchar * album_name,
+	gchar * full_path
+) {
+	KotoAlbum * album = index_add_album(ctx->lib, artist, album_name, full_path);
+
+	index_folder_walk(ctx, full_path, 2); // Index inside the album
+
+	if (ctx->pool != NULL) { // Tracks may still be in flight
+		ctx->albums = g_list_prepend(ctx->albums, album); // Commit once everything has been merged
+	} else {
+		koto_album_commit(album); // Save to database immediately
+	}
+}
+
+static void index_folder_walk(
+	KotoIndexerContext * ctx,
+	gchar * path,
+	guint depth
 ) {
 	depth++;
 
@@ -51,34 +511,17 @@ void index_folder(
 
 		if (entry->d_type == DT_DIR) { // Directory
 			if (depth == 1) { // If we are following (ARTIST,AUTHOR,PODCAST)/ALBUM then this would be artist
-				KotoArtist * artist = koto_artist_new(entry->d_name); // Attempt to get the artist
-
-				if (KOTO_IS_ARTIST(artist)) {
-					koto_artist_set_path(artist, self, full_path, TRUE); // Add the path for this library on this Artist and commit immediately
-					koto_cartographer_add_artist(koto_maps, artist); // Add the artist to cartographer
-					index_folder(self, full_path, depth); // Index this directory
-					koto_artist_set_as_finalized(artist); // Indicate it is finalized
-				}
+				index_artist_directory(ctx, entry->d_name, full_path);
 			} else if (depth == 2) { // If we are following FOLDER/ARTIST/ALBUM then this would be album
 				gchar * artist_name = g_path_get_basename(path); // Get the last entry from our path which is probably the artist
 				KotoArtist * artist = koto_cartographer_get_artist_by_name(koto_maps, artist_name);
+				g_free(artist_name);
 
 				if (!KOTO_IS_ARTIST(artist)) { // Not an artist
 					continue;
 				}
 
-				gchar * artist_uuid = koto_artist_get_uuid(artist); // Get the artist's UUID
-
-				KotoAlbum * album = koto_album_new(artist_uuid);
-
-				koto_album_set_path(album, self, full_path);
-
-				koto_cartographer_add_album(koto_maps, album); // Add our album to the cartographer
-				koto_artist_add_album(artist, album); // Add the album
-
-				index_folder(self, full_path, depth); // Index inside the album
-				koto_album_commit(album); // Save to database immediately
-				g_free(artist_name);
+				index_album_directory(ctx, artist, entry->d_name, full_path);
 			} else if (depth == 3) { // Possibly CD within album
 				gchar ** split = g_strsplit(full_path, G_DIR_SEPARATOR_S, -1);
 				guint split_len = g_strv_length(split);
@@ -117,35 +560,473 @@ void index_folder(
 					continue;
 				}
 
-				index_folder(self, full_path, depth); // Index inside the album
+				index_folder_walk(ctx, full_path, depth); // Index inside the album
 			}
 		} else if ((entry->d_type == DT_REG)) { // Is a file in artist folder or lower in FS hierarchy
-			index_file(self, full_path); // Index this audio file or weird ogg thing
+			index_handle_file(ctx, full_path); // Index this file unless it is unchanged
 		}
 
 		g_free(full_path);
 	}
 
 	closedir(dir); // Close the directory
+
+	if (ctx->pool != NULL) { // Have workers
+		index_merge_ready_results(ctx); // Merge whatever our workers have finished so far, keeping the results queue short
+	}
+}
+
+static void index_step_free(KotoIndexerStep * step) {
+	if (step == NULL) {
+		return;
+	}
+
+	g_free(step->relative_path);
+
+	if (step->track_uuids != NULL) {
+		g_ptr_array_unref(step->track_uuids);
+	}
+
+	g_free(step->artist_name);
+	g_free(step->album_name);
+	g_free(step->full_path);
+	index_file_free(step->indexed_file);
+	g_free(step);
+}
+
+/**
+ * Create a set of changes to a library. Changes are scanned in the calling thread, which may be any thread, then applied to our cartographer and database on the main thread with index_changes_apply.
+ **/
+KotoIndexerChanges * index_changes_new(KotoLibrary * lib) {
+	KotoIndexerChanges * changes = g_new0(KotoIndexerChanges, 1);
+	changes->lib = g_object_ref(lib);
+	changes->removals = g_queue_new();
+	changes->steps = g_queue_new();
+	return changes;
+}
+
+static void index_changes_free(KotoIndexerChanges * changes) {
+	g_queue_free_full(changes->removals, (GDestroyNotify) index_step_free);
+	g_queue_free_full(changes->steps, (GDestroyNotify) index_step_free);
+	index_step_free(changes->pending_artist);
+	index_step_free(changes->pending_album);
+	g_list_free(changes->albums);
+	g_list_free(changes->artists);
+	g_object_unref(changes->lib);
+	g_free(changes);
+}
+
+static gboolean index_changes_is_removed(
+	KotoIndexerChanges * changes,
+	const gchar * relative_path
+) {
+	for (GList * cur_list = changes->removals->head; cur_list != NULL; cur_list = cur_list->next) { // For each path being removed
+		KotoIndexerStep * step = cur_list->data;
+		gsize len = strlen(step->relative_path);
+
+		if (g_str_has_prefix(relative_path, step->relative_path) && ((relative_path[len] == '\0') || (relative_path[len] == G_DIR_SEPARATOR))) { // Is this path or under it
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void index_changes_set_pending(
+	KotoIndexerStep ** pending,
+	KotoIndexerStep * step
+) {
+	index_step_free(*pending); // Nothing under the previous directory changed
+	*pending = step;
+}
+
+static void index_changes_push_file(
+	KotoIndexerChanges * changes,
+	KotoIndexedFile * indexed_file
+) {
+	if (changes->pending_artist != NULL) { // First change under this artist
+		g_queue_push_tail(changes->steps, changes->pending_artist);
+		changes->pending_artist = NULL;
+	}
+
+	if (changes->pending_album != NULL) { // First change under this album
+		g_queue_push_tail(changes->steps, changes->pending_album);
+		changes->pending_album = NULL;
+	}
+
+	KotoIndexerStep * step = g_new0(KotoIndexerStep, 1);
+	step->type = KOTO_INDEXER_STEP_FILE;
+	step->indexed_file = indexed_file;
+	g_queue_push_tail(changes->steps, step);
+}
+
+static KotoIndexerStep * index_changes_new_directory(
+	KotoIndexerStepType type,
+	const gchar * artist_name,
+	const gchar * album_name,
+	const gchar * full_path
+) {
+	KotoIndexerStep * step = g_new0(KotoIndexerStep, 1);
+	step->type = type;
+	step->artist_name = g_strdup(artist_name);
+	step->album_name = g_strdup(album_name);
+	step->full_path = g_strdup(full_path);
+	return step;
+}
+
+static void index_changes_scan_file(
+	KotoIndexerChanges * changes,
+	GHashTable * fingerprints,
+	gchar * full_path
+) {
+	struct stat file_stat;
+
+	if (stat(full_path, &file_stat) != 0) { // Failed to stat the file
+		return;
+	}
+
+	KotoIndexedFile * indexed_file = index_file_new(changes->lib, full_path, &file_stat);
+	gboolean unchanged = index_file_is_unchanged(indexed_file, g_hash_table_lookup(fingerprints, indexed_file->relative_path)) && !index_changes_is_removed(changes, indexed_file->relative_path); // Fingerprints of removed paths are about to be deleted
+	g_hash_table_remove(fingerprints, indexed_file->relative_path); // Seen this file, so it was not removed
+
+	if (unchanged) { // File is unchanged since we last indexed it
+		changes->skipped++;
+		index_file_free(indexed_file);
+		return;
+	}
+
+	index_file_parse(indexed_file, koto_mime_helpers_get_magic_cookie()); // Probe and parse the file in this thread
+	index_changes_push_file(changes, indexed_file);
+}
+
+static void index_changes_walk(
+	KotoIndexerChanges * changes,
+	GHashTable * fingerprints,
+	const gchar * path,
+	guint depth
+) {
+	depth++;
+
+	DIR * dir = opendir(path); // Attempt to open our directory
+
+	if (dir == NULL) {
+		return;
+	}
+
+	struct dirent * entry;
+
+	while ((entry = readdir(dir))) {
+		if (g_str_has_prefix(entry->d_name, ".")) { // A reference to parent dir, self, or a hidden item
+			continue;
+		}
+
+		gchar * full_path = g_strdup_printf("%s%s%s", path, G_DIR_SEPARATOR_S, entry->d_name);
+
+		if ((entry->d_type == DT_DIR) && (depth == 1)) { // Artist
+			index_changes_set_pending(&changes->pending_artist, index_changes_new_directory(KOTO_INDEXER_STEP_ARTIST, entry->d_name, NULL, full_path));
+			index_changes_walk(changes, fingerprints, full_path, depth);
+			index_changes_set_pending(&changes->pending_artist, NULL);
+		} else if ((entry->d_type == DT_DIR) && (depth == 2)) { // Album
+			gchar * artist_name = g_path_get_basename(path);
+			index_changes_set_pending(&changes->pending_album, index_changes_new_directory(KOTO_INDEXER_STEP_ALBUM, artist_name, entry->d_name, full_path));
+			g_free(artist_name);
+
+			index_changes_walk(changes, fingerprints, full_path, depth);
+			index_changes_set_pending(&changes->pending_album, NULL);
+		} else if ((entry->d_type == DT_DIR) && (depth == 3)) { // Possibly CD within album
+			index_changes_walk(changes, fingerprints, full_path, depth);
+		} else if (entry->d_type == DT_REG) { // Is a file in artist folder or lower in FS hierarchy
+			index_changes_scan_file(changes, fingerprints, full_path);
+		}
+
+		g_free(full_path);
+	}
+
+	closedir(dir);
+}
+
+/**
+ * Scan the removal of everything at or under relative_path, such as a deleted file or directory.
+ **/
+void index_changes_scan_removal(
+	KotoIndexerChanges * changes,
+	const gchar * relative_path
+) {
+	if (!koto_utils_string_is_valid(relative_path)) { // No path to remove
+		return;
+	}
+
+	KotoIndexerStep * step = g_new0(KotoIndexerStep, 1);
+	step->type = KOTO_INDEXER_STEP_REMOVE;
+	step->relative_path = g_strdup(relative_path);
+	step->track_uuids = g_ptr_array_new_with_free_func(g_free);
+
+	sqlite3 * reader = koto_db_get_reader();
+	sqlite3_stmt * stmt = NULL;
+
+	if (sqlite3_prepare_v2(reader, "SELECT track_id FROM files WHERE " KOTO_DB_FILES_UNDER_PATH " AND track_id IS NOT NULL", -1, &stmt, NULL) == SQLITE_OK) { // Prepared our query
+		sqlite3_bind_text(stmt, 1, koto_library_get_uuid(changes->lib), -1, SQLITE_STATIC);
+		sqlite3_bind_text(stmt, 2, relative_path, -1, SQLITE_STATIC);
+
+		while (sqlite3_step(stmt) == SQLITE_ROW) { // For each track under this path
+			const gchar * track_uuid = (const gchar*) sqlite3_column_text(stmt, 0);
+
+			if (koto_utils_string_is_valid(track_uuid)) {
+				g_ptr_array_add(step->track_uuids, g_strdup(track_uuid));
+			}
+		}
+	} else {
+		g_warning("Failed to read files to remove for %s: %s", relative_path, sqlite3_errmsg(reader));
+	}
+
+	sqlite3_finalize(stmt);
+	g_queue_push_tail(changes->removals, step);
+}
+
+/**
+ * Scan the artist, album or file at relative_path, parsing any files that changed since we last indexed them.
+ **/
+void index_changes_scan_subtree(
+	KotoIndexerChanges * changes,
+	const gchar * relative_path
+) {
+	gchar ** split = g_strsplit(relative_path, G_DIR_SEPARATOR_S, -1); // Split into artist, album, etc.
+	guint split_len = g_strv_length(split);
+
+	if ((split_len == 0) || !koto_utils_string_is_valid(split[0])) { // No artist to index
+		g_strfreev(split);
+		return;
+	}
+
+	gchar * artist_path = g_build_filename(koto_library_get_path(changes->lib), split[0], NULL);
+
+	if (!g_file_test(artist_path, G_FILE_TEST_IS_DIR)) { // Artist is not a directory, nothing we index
+		g_free(artist_path);
+		g_strfreev(split);
+		return;
+	}
+
+	GHashTable * fingerprints = index_load_fingerprints(changes->lib, relative_path); // Only need the fingerprints under this subtree
+	index_changes_set_pending(&changes->pending_artist, index_changes_new_directory(KOTO_INDEXER_STEP_ARTIST, split[0], NULL, artist_path)); // Ensure we have the artist, even if only an album changed
+
+	if (split_len == 1) { // Subtree is the artist
+		index_changes_walk(changes, fingerprints, artist_path, 1);
+	} else {
+		gchar * child_path = g_build_filename(artist_path, split[1], NULL); // Album directory or track directly in the artist directory
+
+		if (g_file_test(child_path, G_FILE_TEST_IS_DIR)) { // Is an album
+			index_changes_set_pending(&changes->pending_album, index_changes_new_directory(KOTO_INDEXER_STEP_ALBUM, split[0], split[1], child_path));
+			index_changes_walk(changes, fingerprints, child_path, 2);
+			index_changes_set_pending(&changes->pending_album, NULL);
+		} else if (g_file_test(child_path, G_FILE_TEST_IS_REGULAR)) { // Is a file directly in the artist directory
+			index_changes_scan_file(changes, fingerprints, child_path);
+		}
+
+		g_free(child_path);
+	}
+
+	index_changes_set_pending(&changes->pending_artist, NULL);
+	g_hash_table_unref(fingerprints);
+	g_free(artist_path);
+	g_strfreev(split);
+}
+
+/**
+ * Scan the entire library, picking up anything that was added, changed or removed since we last indexed it.
+ **/
+void index_changes_scan_library(KotoIndexerChanges * changes) {
+	gchar * library_path = koto_library_get_path(changes->lib);
+	GHashTable * fingerprints = index_load_fingerprints(changes->lib, NULL);
+
+	index_changes_walk(changes, fingerprints, library_path, 0); // Every file we see is removed from our fingerprints
+
+	GHashTable * removed_paths = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	GHashTableIter iter;
+	gpointer relative_path;
+
+	g_hash_table_iter_init(&iter, fingerprints);
+
+	while (g_hash_table_iter_next(&iter, &relative_path, NULL)) { // For each file we knew about that is no longer there
+		gchar ** split = g_strsplit(relative_path, G_DIR_SEPARATOR_S, -1);
+		guint split_len = g_strv_length(split);
+		gchar * artist_path = g_build_filename(library_path, split[0], NULL);
+		gchar * album_path = (split_len >= 3) ? g_build_filename(artist_path, split[1], NULL) : NULL;
+		gchar * removed_path = NULL;
+
+		if (!g_file_test(artist_path, G_FILE_TEST_IS_DIR)) { // Entire artist is gone
+			removed_path = g_strdup(split[0]);
+		} else if ((album_path != NULL) && !g_file_test(album_path, G_FILE_TEST_IS_DIR)) { // Entire album is gone
+			removed_path = g_build_filename(split[0], split[1], NULL);
+		} else {
+			removed_path = g_strdup(relative_path);
+		}
+
+		if (!g_hash_table_contains(removed_paths, removed_path)) { // Not already removing this
+			index_changes_scan_removal(changes, removed_path);
+			g_hash_table_add(removed_paths, removed_path);
+		} else {
+			g_free(removed_path);
+		}
+
+		g_free(album_path);
+		g_free(artist_path);
+		g_strfreev(split);
+	}
+
+	g_hash_table_unref(removed_paths);
+	g_hash_table_unref(fingerprints);
+}
+
+static void index_changes_finish(KotoIndexerChanges * changes) {
+	GList * cur_list;
+
+	for (cur_list = changes->albums; cur_list != NULL; cur_list = cur_list->next) { // For each album we added or updated
+		koto_album_commit(KOTO_ALBUM(cur_list->data)); // Save now that all of its tracks have been merged
+	}
+
+	for (cur_list = changes->artists; cur_list != NULL; cur_list = cur_list->next) { // For each artist we added or updated
+		koto_artist_set_as_finalized(KOTO_ARTIST(cur_list->data)); // Indicate it is finalized
+	}
+
+	koto_db_writer_end_batch(); // Let the writer go back to smaller transactions
+
+	if (changes->skipped > 0) { // Skipped some files
+		g_message("Skipped %u unchanged files while indexing %s", changes->skipped, koto_library_get_path(changes->lib));
+	}
+
+	if (changes->done != NULL) { // Have something to call once we are done
+		changes->done(changes->done_data);
+	}
+
+	index_changes_free(changes);
+}
+
+static gboolean index_changes_apply_steps(gpointer user_data) {
+	KotoIndexerChanges * changes = user_data;
+
+	for (guint i = 0; i < KOTO_INDEXER_STEPS_PER_IDLE; i++) { // Only do a bounded amount of work before yielding back to the main loop
+		KotoIndexerStep * step = g_queue_pop_head(changes->removals);
+
+		if (step == NULL) { // Done removing
+			step = g_queue_pop_head(changes->steps);
+		}
+
+		if (step == NULL) { // Nothing left to apply
+			index_changes_finish(changes);
+			return G_SOURCE_REMOVE;
+		}
+
+		switch (step->type) {
+			case KOTO_INDEXER_STEP_REMOVE:
+				index_remove_path(changes->lib, step->relative_path, step->track_uuids);
+				break;
+			case KOTO_INDEXER_STEP_ARTIST: {
+				KotoArtist * artist = index_add_artist(changes->lib, step->artist_name, step->full_path);
+
+				if (KOTO_IS_ARTIST(artist)) { // Have the artist
+					changes->artists = g_list_prepend(changes->artists, artist); // Finalize once everything has been merged
+				}
+
+				break;
+			}
+			case KOTO_INDEXER_STEP_ALBUM: {
+				KotoArtist * artist = koto_cartographer_get_artist_by_name(koto_maps, step->artist_name);
+
+				if (KOTO_IS_ARTIST(artist)) { // Have the artist of this album
+					changes->albums = g_list_prepend(changes->albums, index_add_album(changes->lib, artist, step->album_name, step->full_path)); // Commit once everything has been merged
+				}
+
+				break;
+			}
+			case KOTO_INDEXER_STEP_FILE:
+				index_merge_result(step->indexed_file); // Merges and frees the file
+				step->indexed_file = NULL;
+				break;
+		}
+
+		index_step_free(step);
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+/**
+ * Apply scanned changes to our cartographer and database on the main thread, in bounded batches from an idle callback. Takes ownership of the changes, calling done on the main thread once everything is applied.
+ **/
+void index_changes_apply(
+	KotoIndexerChanges * changes,
+	GSourceFunc done,
+	gpointer done_data
+) {
+	changes->done = done;
+	changes->done_data = done_data;
+
+	koto_db_writer_begin_batch(koto_config_get_indexer_batch_size(config)); // Group our writes into larger transactions
+	g_idle_add(index_changes_apply_steps, changes);
 }
 
 void index_file(
 	KotoLibrary * lib,
 	const gchar * path
 ) {
-	const char * mime_type = magic_file(magic_cookie, path);
+	struct stat file_stat;
+
+	if (stat(path, &file_stat) != 0) { // Failed to stat the file
+		return;
+	}
+
+	KotoIndexedFile * indexed_file = index_file_new(lib, path, &file_stat);
+	index_file_parse(indexed_file, koto_mime_helpers_get_magic_cookie());
+
+	if (indexed_file->is_audio) { // Is an audio file we parsed
+		index_file_merge(indexed_file);
+	}
+
+	index_file_free(indexed_file);
+}
+
+static KotoIndexedFile * index_file_new(
+	KotoLibrary * lib,
+	const gchar * path,
+	struct stat * file_stat
+) {
+	KotoIndexedFile * indexed_file = g_new0(KotoIndexedFile, 1);
+	indexed_file->lib = lib;
+	indexed_file->path = g_strdup(path);
+	indexed_file->relative_path = koto_library_get_relative_path_to_file(lib, g_strdup(path)); // Strip out library path so we have a relative path to the file
+	indexed_file->fingerprint.mtime = (gint64) file_stat->st_mtime;
+	indexed_file->fingerprint.size = (gint64) file_stat->st_size;
+	indexed_file->fingerprint.inode = (guint64) file_stat->st_ino;
+	indexed_file->probed = FALSE;
+	indexed_file->is_audio = FALSE;
+
+	return indexed_file;
+}
+
+/**
+ * Probe and parse a file into its KotoIndexedFile. This does not touch the cartographer or database, so it is safe to call from indexer workers.
+ **/
+static void index_file_parse(
+	KotoIndexedFile * indexed_file,
+	magic_t cookie
+) {
+	const char * mime_type = koto_mime_helpers_get_mimetype_for_file(indexed_file->path, cookie); // Only uses the cookie when the extension and header are ambiguous
 
 	if (mime_type == NULL) { // Failed to get the mimetype
 		return;
 	}
 
+	indexed_file->probed = TRUE;
+
 	if (!g_str_has_prefix(mime_type, "audio/") && !g_str_has_prefix(mime_type, "video/ogg")) { // Is not an audio file or ogg
 		return;
 	}
 
+	KotoLibrary * lib = indexed_file->lib;
+	const gchar * path = indexed_file->path;
 	gboolean for_audiobook = (koto_library_get_lib_type(lib) == KOTO_LIBRARY_TYPE_AUDIOBOOK);
 
-	gchar * relative_path_to_file = koto_library_get_relative_path_to_file(lib, g_strdup(path)); // Strip out library path so we have a relative path to the file
+	gchar * relative_path_to_file = indexed_file->relative_path;
 	gchar * file_basename = g_path_get_basename(relative_path_to_file);
 
 	gchar ** split_on_relative_slashes = g_strsplit(relative_path_to_file, G_DIR_SEPARATOR_S, -1); // Split based on separator (e.g. / )
@@ -175,6 +1056,7 @@ void index_file(
 
 	// #endregion
 
+	KotoTrackMetadata * metadata = koto_track_helpers_get_metadata_for_file(path); // Read all of our tags in one pass
 	gchar * file_name = NULL;
 
 	if (for_audiobook) { // If this is for an audiobook library
@@ -188,29 +1070,71 @@ void index_file(
 	}
 
 	if (!koto_utils_string_is_valid(file_name)) { // No valid file name yet
-		file_name = koto_track_helpers_get_name_for_file(path, artist_author_podcast_name); // Get the name of the file
+		file_name = koto_track_helpers_get_name_for_file(path, artist_author_podcast_name, metadata); // Get the name of the file
 	}
 
 	g_strfreev(split_on_relative_slashes);
 	g_free(file_basename);
 
-	gchar * sorta_uniqueish_key = NULL;
+	indexed_file->artist_name = artist_author_podcast_name;
+	indexed_file->album_name = album_or_audiobook_name;
+	indexed_file->file_name = file_name;
+	indexed_file->cd = cd;
+	indexed_file->metadata = metadata;
+	indexed_file->is_audio = TRUE;
+}
 
-	if (koto_utils_string_is_valid(album_or_audiobook_name)) { // Have audiobook or album name
-		sorta_uniqueish_key = g_strdup_printf("%s-%s-%s", artist_author_podcast_name, album_or_audiobook_name, file_name);
-	} else { // No audiobook or album name
-		sorta_uniqueish_key = g_strdup_printf("%s-%s", artist_author_podcast_name, file_name);
+/**
+ * Use any embedded picture read with the tags as the album art, when the album has no art of its own
+ **/
+static void index_file_apply_embedded_art(
+	KotoIndexedFile * indexed_file,
+	KotoTrack * track
+) {
+	if ((indexed_file->metadata == NULL) || !koto_utils_string_is_valid(indexed_file->metadata->art_path)) { // No embedded art
+		return;
 	}
 
+	gchar * album_uuid = NULL;
+	g_object_get(track, "album-uuid", &album_uuid, NULL);
+
+	KotoAlbum * album = koto_utils_string_is_valid(album_uuid) ? koto_cartographer_get_album_by_uuid(koto_maps, album_uuid) : NULL;
+	g_free(album_uuid);
+
+	if (!KOTO_IS_ALBUM(album)) { // Track is not part of an album
+		return;
+	}
+
+	gchar * current_art = koto_album_get_art(album);
+
+	if (!koto_utils_string_is_valid(current_art)) { // No art found next to the files
+		koto_album_set_album_art(album, indexed_file->metadata->art_path);
+	}
+
+	g_free(current_art);
+}
+
+/**
+ * Merge a parsed file into our cartographer and database, returning the UUID of its track. This must only be called from the thread that owns indexing for the library.
+ **/
+static gchar * index_file_merge(KotoIndexedFile * indexed_file) {
+	KotoLibrary * lib = indexed_file->lib;
+	gchar * artist_author_podcast_name = indexed_file->artist_name;
+	gchar * album_or_audiobook_name = indexed_file->album_name;
+	gchar * file_name = indexed_file->file_name;
+
+	gchar * sorta_uniqueish_key = koto_cartographer_build_uniqueish_key(artist_author_podcast_name, album_or_audiobook_name, file_name);
 	KotoTrack * track = koto_cartographer_get_track_by_uniqueish_key(koto_maps, sorta_uniqueish_key); // Attempt to get any existing KotoTrack
+	g_free(sorta_uniqueish_key);
 
 	if (KOTO_IS_TRACK(track)) { // Got a track already
-		koto_track_set_path(track, lib, relative_path_to_file); // Add this path, which will determine the associated library within that function
+		koto_track_set_metadata(track, indexed_file->metadata); // File is new or changed, so refresh the metadata
+		koto_track_set_path(track, lib, indexed_file->relative_path); // Add this path, which will determine the associated library within that function
 	} else { // Don't already have a track for this file
 		KotoArtist * artist = koto_cartographer_get_artist_by_name(koto_maps, artist_author_podcast_name); // Get the possible artist
 
 		if (!KOTO_IS_ARTIST(artist)) { // Have an artist for this already
-			return;
+			return NULL;
 		}
 
 		KotoAlbum * album = NULL;
@@ -222,8 +1146,9 @@ void index_file(
 
 		gchar * album_uuid = KOTO_IS_ALBUM(album) ? koto_album_get_uuid(album) : NULL;
 
-		track = koto_track_new(koto_artist_get_uuid(artist), album_uuid, file_name, cd);
-		koto_track_set_path(track, lib, relative_path_to_file); // Immediately add the path to this file, for this Library
+		track = koto_track_new(koto_artist_get_uuid(artist), album_uuid, file_name, indexed_file->cd);
+		koto_track_set_metadata(track, indexed_file->metadata); // Apply the tags we already read, so setting the path does not read the file again
+		koto_track_set_path(track, lib, indexed_file->relative_path); // Immediately add the path to this file, for this Library
 		koto_artist_add_track(artist, track); // Add the track to the artist in the event this is a podcast (no album) or the track is directly in the artist directory
 
 		if (KOTO_IS_ALBUM(album)) { // Have an album
@@ -233,7 +1158,46 @@ void index_file(
 		koto_cartographer_add_track(koto_maps, track); // Add to our cartographer tracks hashtable
 	}
 
-	if (KOTO_IS_TRACK(track)) { // Is a track
-		koto_track_commit(track); // Save the track immediately
+	if (!KOTO_IS_TRACK(track)) { // Not a track
+		return NULL;
+	}
+
+	index_file_apply_embedded_art(indexed_file, track);
+	koto_track_commit(track); // Save the track immediately
+	return koto_track_get_uuid(track);
+}
+
+static void index_file_commit_fingerprint(
+	KotoIndexedFile * indexed_file,
+	const gchar * track_uuid
+) {
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_FILE);
+
+	koto_db_write_bind_text(write, 1, koto_library_get_uuid(indexed_file->lib));
+	koto_db_write_bind_text(write, 2, indexed_file->relative_path);
+	koto_db_write_bind_int64(write, 3, indexed_file->fingerprint.mtime);
+	koto_db_write_bind_int64(write, 4, indexed_file->fingerprint.size);
+	koto_db_write_bind_int64(write, 5, indexed_file->fingerprint.inode);
+
+	if (koto_utils_string_is_valid(track_uuid)) { // Have a track for this file
+		koto_db_write_bind_text(write, 6, track_uuid);
+	} else { // Files that are not tracks have no track
+		koto_db_write_bind_null(write, 6);
+	}
+
+	koto_db_writer_push(write, "Failed to save the fingerprint for this file");
+}
+
+static void index_file_free(KotoIndexedFile * indexed_file) {
+	if (indexed_file == NULL) {
+		return;
 	}
-}
\ No newline at end of file
+
+	g_free(indexed_file->path);
+	g_free(indexed_file->relative_path);
+	g_free(indexed_file->artist_name);
+	g_free(indexed_file->album_name);
+	g_free(indexed_file->file_name);
+	koto_track_helpers_free_metadata(indexed_file->metadata);
+	g_free(indexed_file);
+}
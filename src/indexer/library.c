@@ -15,13 +15,24 @@
  * limitations under the License.
  */
 
+#include <dirent.h>
 #include "../config/config.h"
+#include "../db/cartographer.h"
 #include "../koto-utils.h"
 #include "structs.h"
 
+#define KOTO_LIBRARY_WATCH_DEBOUNCE_MS 1500 // Window over which filesystem events are coalesced before re-indexing
+#define KOTO_LIBRARY_WATCH_MAX_DEPTH 3 // Artist, album and disc directories
+
+extern KotoCartographer * koto_maps;
 extern KotoConfig * config;
 extern GVolumeMonitor * volume_monitor;
 
+typedef enum {
+	KOTO_LIBRARY_CHANGE_REINDEX = 1 << 0,
+	KOTO_LIBRARY_CHANGE_REMOVE = 1 << 1
+} KotoLibraryChange;
+
 enum {
 	PROP_0,
 	PROP_TYPE,
@@ -63,6 +74,11 @@ struct _KotoLibrary {
 	gchar * path;
 	gchar * relative_path;
 	gchar * name;
+
+	GHashTable * monitors; // Directory paths to their GFileMonitor
+	GHashTable * pending_changes; // Relative paths to the KotoLibraryChange flags accumulated during the debounce window
+	guint pending_changes_timeout;
+	gboolean applying_changes;
 };
 
 struct _KotoLibraryClass {
@@ -164,7 +180,10 @@ static void koto_library_class_init(KotoLibraryClass * c) {
 }
 
 static void koto_library_init(KotoLibrary * self) {
-	(void) self;
+	self->monitors = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+	self->pending_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->pending_changes_timeout = 0;
+	self->applying_changes = FALSE;
 }
 
 static void koto_library_get_property(
@@ -280,7 +299,13 @@ void koto_library_index(KotoLibrary * self) {
 		return;
 	}
 
-	index_folder(self, self->path, 0); // Start index operation at the top
+	guint workers = koto_config_get_indexer_workers(config); // Get how many workers we should probe and parse files with
+
+	if (workers > 1) { // Have multiple workers
+		index_folder_parallel(self, self->path, workers); // Start a parallel index operation at the top
+	} else {
+		index_folder(self, self->path, 0); // Start index operation at the top
+	}
 }
 
 gboolean koto_library_is_available(KotoLibrary * self) {
@@ -291,6 +316,298 @@ gboolean koto_library_is_available(KotoLibrary * self) {
 	return FALSE;
 }
 
+typedef struct {
+	KotoLibrary * library;
+	GList * directories;
+} KotoLibraryWatchDirectories;
+
+typedef struct {
+	KotoLibrary * library;
+	GHashTable * changes;
+} KotoLibraryChangeBatch;
+
+static void koto_library_watch_collect_directories(
+	const gchar * path,
+	guint depth,
+	GList ** directories
+) {
+	*directories = g_list_prepend(*directories, g_strdup(path));
+
+	if (depth >= KOTO_LIBRARY_WATCH_MAX_DEPTH) { // Deep enough, index_folder does not descend further
+		return;
+	}
+
+	DIR * dir = opendir(path);
+
+	if (dir == NULL) {
+		return;
+	}
+
+	struct dirent * entry;
+
+	while ((entry = readdir(dir))) {
+		if ((entry->d_type != DT_DIR) || g_str_has_prefix(entry->d_name, ".")) { // Not a directory or is hidden
+			continue;
+		}
+
+		gchar * full_path = g_build_filename(path, entry->d_name, NULL);
+		koto_library_watch_collect_directories(full_path, depth + 1, directories);
+		g_free(full_path);
+	}
+
+	closedir(dir);
+}
+
+static void koto_library_queue_change(
+	KotoLibrary * self,
+	GFile * file,
+	KotoLibraryChange change
+);
+
+static void koto_library_handle_monitor_changed(
+	GFileMonitor * monitor,
+	GFile * file,
+	GFile * other_file,
+	GFileMonitorEvent ev,
+	gpointer user_data
+) {
+	(void) monitor;
+	KotoLibrary * self = user_data;
+
+	switch (ev) {
+		case G_FILE_MONITOR_EVENT_CREATED:
+		case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		case G_FILE_MONITOR_EVENT_MOVED_IN:
+			koto_library_queue_change(self, file, KOTO_LIBRARY_CHANGE_REINDEX);
+			break;
+		case G_FILE_MONITOR_EVENT_DELETED:
+		case G_FILE_MONITOR_EVENT_MOVED_OUT:
+			koto_library_queue_change(self, file, KOTO_LIBRARY_CHANGE_REMOVE);
+			break;
+		case G_FILE_MONITOR_EVENT_RENAMED:
+			koto_library_queue_change(self, file, KOTO_LIBRARY_CHANGE_REMOVE); // Old name is gone
+			koto_library_queue_change(self, other_file, KOTO_LIBRARY_CHANGE_REINDEX); // New name should be indexed
+			break;
+		default:
+			break;
+	}
+}
+
+static void koto_library_monitor_directory(
+	KotoLibrary * self,
+	const gchar * path
+) {
+	if (g_hash_table_contains(self->monitors, path)) { // Already monitoring this directory
+		return;
+	}
+
+	GFile * dir = g_file_new_for_path(path);
+	GError * monitor_err = NULL;
+	GFileMonitor * monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_WATCH_MOVES, NULL, &monitor_err);
+	g_object_unref(dir);
+
+	if (monitor_err != NULL) { // Failed to monitor this directory
+		g_warning("Failed to watch %s for changes: %s", path, monitor_err->message);
+		g_error_free(monitor_err);
+		return;
+	}
+
+	g_signal_connect(monitor, "changed", G_CALLBACK(koto_library_handle_monitor_changed), self);
+	g_hash_table_replace(self->monitors, g_strdup(path), monitor);
+}
+
+static void koto_library_unmonitor_directory(
+	KotoLibrary * self,
+	const gchar * path
+) {
+	gchar * prefix = g_strdup_printf("%s%s", path, G_DIR_SEPARATOR_S);
+	GHashTableIter iter;
+	gpointer monitored_path, monitor;
+
+	g_hash_table_iter_init(&iter, self->monitors);
+
+	while (g_hash_table_iter_next(&iter, &monitored_path, &monitor)) { // For each directory we monitor
+		if ((g_strcmp0(monitored_path, path) == 0) || g_str_has_prefix(monitored_path, prefix)) { // Is this directory or under it
+			g_file_monitor_cancel(G_FILE_MONITOR(monitor));
+			g_hash_table_iter_remove(&iter);
+		}
+	}
+
+	g_free(prefix);
+}
+
+static gboolean koto_library_watch_directories(gpointer user_data) {
+	KotoLibraryWatchDirectories * watch = user_data;
+	GList * cur_list;
+
+	for (cur_list = watch->directories; cur_list != NULL; cur_list = cur_list->next) { // For each directory to watch
+		koto_library_monitor_directory(watch->library, cur_list->data);
+	}
+
+	g_list_free_full(watch->directories, g_free);
+	g_object_unref(watch->library);
+	g_free(watch);
+	return G_SOURCE_REMOVE;
+}
+
+static gpointer koto_library_apply_changes_thread(gpointer user_data);
+
+static gboolean koto_library_apply_pending_changes(gpointer user_data) {
+	KotoLibrary * self = user_data;
+
+	if (self->applying_changes) { // Still applying a previous batch
+		return G_SOURCE_CONTINUE; // Try again after another window
+	}
+
+	self->pending_changes_timeout = 0;
+
+	KotoLibraryChangeBatch * batch = g_new0(KotoLibraryChangeBatch, 1);
+	batch->library = g_object_ref(self);
+	batch->changes = self->pending_changes; // Take our accumulated changes
+	self->pending_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->applying_changes = TRUE;
+
+	g_thread_unref(g_thread_new("applying-library-changes", koto_library_apply_changes_thread, batch)); // Index off the main thread
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean koto_library_finish_applying_changes(gpointer user_data) {
+	KotoLibrary * self = user_data;
+	self->applying_changes = FALSE;
+
+	if ((g_hash_table_size(self->pending_changes) > 0) && (self->pending_changes_timeout == 0)) { // Changes came in while we were applying
+		self->pending_changes_timeout = g_timeout_add(KOTO_LIBRARY_WATCH_DEBOUNCE_MS, koto_library_apply_pending_changes, self);
+	}
+
+	g_object_unref(self);
+	return G_SOURCE_REMOVE;
+}
+
+static gpointer koto_library_apply_changes_thread(gpointer user_data) {
+	KotoLibraryChangeBatch * batch = user_data;
+	KotoIndexerChanges * changes = index_changes_new(batch->library);
+	GHashTableIter iter;
+	gpointer relative_path, change;
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, &relative_path, &change)) { // Scan removals first, so replaced files are re-indexed cleanly
+		if (GPOINTER_TO_UINT(change) & KOTO_LIBRARY_CHANGE_REMOVE) {
+			index_changes_scan_removal(changes, relative_path);
+		}
+	}
+
+	g_hash_table_iter_init(&iter, batch->changes);
+
+	while (g_hash_table_iter_next(&iter, &relative_path, &change)) { // Walk and parse only the affected subtrees
+		if (GPOINTER_TO_UINT(change) & KOTO_LIBRARY_CHANGE_REINDEX) {
+			index_changes_scan_subtree(changes, relative_path);
+		}
+	}
+
+	g_hash_table_unref(batch->changes);
+	index_changes_apply(changes, koto_library_finish_applying_changes, batch->library); // Apply on the main thread, since our objects back GTK models, then hand our library reference back
+	g_free(batch);
+	return NULL;
+}
+
+static gpointer koto_library_reconcile_thread(gpointer user_data) {
+	KotoLibrary * self = user_data;
+	KotoIndexerChanges * changes = index_changes_new(self);
+
+	index_changes_scan_library(changes); // Pick up anything added, changed or removed while we were not running
+	koto_library_watch(self); // Watch before applying, so anything changed in the meantime waits for this batch rather than being missed
+	index_changes_apply(changes, koto_library_finish_applying_changes, self); // Hand our library reference back once applied
+	return NULL;
+}
+
+/**
+ * Bring a library we indexed during a previous run up to date with its directory, then watch it for changes.
+ * Must be called from the main thread, once the library has been loaded from the database.
+ **/
+void koto_library_reconcile(KotoLibrary * self) {
+	if (!KOTO_IS_LIBRARY(self) || self->should_index) { // Not a library, or is new and gets fully indexed instead
+		return;
+	}
+
+	if (!koto_utils_string_is_valid(self->path) || !g_file_test(self->path, G_FILE_TEST_IS_DIR)) { // Library is not currently available, so don't mistake its files for being removed
+		return;
+	}
+
+	self->applying_changes = TRUE; // Hold back watched changes until we are done
+	g_thread_unref(g_thread_new("reconciling-library", koto_library_reconcile_thread, g_object_ref(self)));
+}
+
+static void koto_library_queue_change(
+	KotoLibrary * self,
+	GFile * file,
+	KotoLibraryChange change
+) {
+	if (!G_IS_FILE(file)) {
+		return;
+	}
+
+	gchar * path = g_file_get_path(file);
+	gchar * basename = g_path_get_basename(path);
+	gchar * relative_path = koto_library_get_relative_path_to_file(self, path);
+	gchar ** split = g_strsplit(relative_path, G_DIR_SEPARATOR_S, -1);
+	guint depth = koto_utils_string_is_valid(relative_path) ? g_strv_length(split) : 0;
+	gboolean is_dir = g_file_test(path, G_FILE_TEST_IS_DIR);
+	gchar * key = NULL;
+
+	if (g_str_has_prefix(basename, ".") || (depth == 0)) { // Hidden item, which index_folder ignores as well, or the library itself
+		key = NULL;
+	} else if (change & KOTO_LIBRARY_CHANGE_REMOVE) { // Removals apply to exactly what was removed
+		koto_library_unmonitor_directory(self, path);
+		key = g_strdup(relative_path);
+	} else if ((depth > 1) || is_dir) { // Top-level files are not indexed, everything else re-indexes the album or artist containing it
+		key = (depth > 2) ? g_build_filename(split[0], split[1], NULL) : g_strdup(relative_path);
+
+		if (is_dir && (depth <= KOTO_LIBRARY_WATCH_MAX_DEPTH)) { // New directory we should watch
+			GList * directories = NULL;
+			koto_library_watch_collect_directories(path, depth, &directories);
+
+			GList * cur_list;
+			for (cur_list = directories; cur_list != NULL; cur_list = cur_list->next) { // For each new directory
+				koto_library_monitor_directory(self, cur_list->data);
+			}
+
+			g_list_free_full(directories, g_free);
+		}
+	}
+
+	if (key != NULL) {
+		KotoLibraryChange existing_change = GPOINTER_TO_UINT(g_hash_table_lookup(self->pending_changes, key));
+		g_hash_table_replace(self->pending_changes, key, GUINT_TO_POINTER(existing_change | change)); // Table takes ownership of key
+
+		if (self->pending_changes_timeout == 0) { // Not already waiting to apply changes
+			self->pending_changes_timeout = g_timeout_add(KOTO_LIBRARY_WATCH_DEBOUNCE_MS, koto_library_apply_pending_changes, self);
+		}
+	}
+
+	g_strfreev(split);
+	g_free(relative_path);
+	g_free(basename);
+	g_free(path);
+}
+
+void koto_library_watch(KotoLibrary * self) {
+	if (!KOTO_IS_LIBRARY(self)) {
+		return;
+	}
+
+	if (!koto_utils_string_is_valid(self->path) || !g_file_test(self->path, G_FILE_TEST_IS_DIR)) { // Library is not currently available
+		return;
+	}
+
+	KotoLibraryWatchDirectories * watch = g_new0(KotoLibraryWatchDirectories, 1);
+	watch->library = g_object_ref(self);
+	watch->directories = NULL;
+
+	koto_library_watch_collect_directories(self->path, 0, &watch->directories); // Walk the directories in the calling thread
+	g_main_context_invoke(NULL, koto_library_watch_directories, watch); // File monitors deliver events on the context they are created in, so create them on the main context
+}
+
 void koto_library_set_name(
 	KotoLibrary * self,
 	gchar * library_name
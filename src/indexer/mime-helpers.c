@@ -0,0 +1,254 @@
+/* mime-helpers.c
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib-2.0/glib.h>
+#include <magic.h>
+#include <stdio.h>
+#include <string.h>
+#include "mime-helpers.h"
+
+#define KOTO_MIME_HEADER_LENGTH 12
+
+extern GHashTable * supported_mimes_hash;
+extern magic_t magic_cookie;
+
+typedef struct {
+	const gchar * extension;
+	const gchar * mimetype; // Mimetype we report, matching what libmagic would
+	const gchar * playback_caps; // GStreamer caps that must be supported for us to trust the extension, NULL if not something we play
+} KotoMimeExtension;
+
+static const KotoMimeExtension koto_mime_extensions[] = {
+	{ "mp3", "audio/mpeg", "audio/mpeg" },
+	{ "flac", "audio/flac", "audio/x-flac" },
+	{ "ogg", "audio/ogg", "application/ogg" },
+	{ "oga", "audio/ogg", "application/ogg" },
+	{ "opus", "audio/ogg", "application/ogg" },
+	{ "m4a", "audio/mp4", "audio/x-m4a" },
+	{ "m4b", "audio/mp4", "audio/x-m4a" },
+	{ "wav", "audio/x-wav", "audio/x-wav" },
+	{ "aif", "audio/x-aiff", "audio/x-aiff" },
+	{ "aiff", "audio/x-aiff", "audio/x-aiff" },
+	{ "wv", "audio/x-wavpack", "audio/x-wavpack" },
+	{ "jpg", "image/jpeg", NULL },
+	{ "jpeg", "image/jpeg", NULL },
+	{ "png", "image/png", NULL },
+	{ "gif", "image/gif", NULL },
+	{ "webp", "image/webp", NULL },
+	{ "bmp", "image/bmp", NULL },
+	{ "cue", "text/plain", NULL },
+	{ "log", "text/plain", NULL },
+	{ "txt", "text/plain", NULL },
+	{ "nfo", "text/plain", NULL },
+	{ "m3u", "text/plain", NULL }, // Playlists are text, not audio, no matter what their registered mimetype says
+	{ "m3u8", "text/plain", NULL },
+	{ "md5", "text/plain", NULL },
+	{ "sfv", "text/plain", NULL },
+	{ "pdf", "application/pdf", NULL },
+};
+
+static gint koto_mime_tier_counts[KOTO_MIME_TIER_COUNT] = {
+	0
+};
+
+static GPrivate koto_mime_thread_magic_cookie = G_PRIVATE_INIT((GDestroyNotify) magic_close); // Closed when the thread exits
+
+static const gchar * koto_mime_helpers_get_mimetype_for_extension(const gchar * path) {
+	const gchar * extension = strrchr(path, '.');
+
+	if ((extension == NULL) || (strchr(extension, G_DIR_SEPARATOR) != NULL)) { // No extension on the file name
+		return NULL;
+	}
+
+	extension++; // Skip the period
+
+	for (guint i = 0; i < G_N_ELEMENTS(koto_mime_extensions); i++) { // For each known extension
+		const KotoMimeExtension * known = &koto_mime_extensions[i];
+
+		if (g_ascii_strcasecmp(extension, known->extension) != 0) { // Not this extension
+			continue;
+		}
+
+		if (known->playback_caps == NULL) { // Not something we play, so the extension alone is enough
+			return known->mimetype;
+		}
+
+		if ((supported_mimes_hash != NULL) && g_hash_table_contains(supported_mimes_hash, known->playback_caps)) { // GStreamer can play this
+			return known->mimetype;
+		}
+
+		return NULL; // Known but not playable here, let the later tiers decide
+	}
+
+	return NULL;
+}
+
+static const gchar * koto_mime_helpers_get_mimetype_for_header(const gchar * path) {
+	FILE * file = fopen(path, "rb");
+
+	if (file == NULL) {
+		return NULL;
+	}
+
+	guchar header[KOTO_MIME_HEADER_LENGTH] = {
+		0
+	};
+
+	size_t len = fread(header, 1, KOTO_MIME_HEADER_LENGTH, file); // Only read the first few bytes
+	fclose(file);
+
+	if (len < 4) { // Too short to say anything about
+		return NULL;
+	}
+
+	if (memcmp(header, "fLaC", 4) == 0) {
+		return "audio/flac";
+	} else if (memcmp(header, "OggS", 4) == 0) {
+		return "audio/ogg";
+	} else if (memcmp(header, "ID3", 3) == 0) {
+		return "audio/mpeg";
+	} else if ((header[0] == 0xFF) && ((header[1] & 0xE0) == 0xE0)) { // MPEG frame sync
+		return ((header[1] & 0x06) == 0) ? "audio/aac" : "audio/mpeg"; // Layer bits of zero denote ADTS AAC
+	} else if (memcmp(header, "wvpk", 4) == 0) {
+		return "audio/x-wavpack";
+	} else if (memcmp(header, "MAC ", 4) == 0) {
+		return "audio/x-ape";
+	} else if ((header[0] == 0xFF) && (header[1] == 0xD8) && (header[2] == 0xFF)) {
+		return "image/jpeg";
+	} else if (memcmp(header, "\x89PNG", 4) == 0) {
+		return "image/png";
+	} else if (memcmp(header, "GIF8", 4) == 0) {
+		return "image/gif";
+	}
+
+	if (len < KOTO_MIME_HEADER_LENGTH) { // Remaining containers need the full header
+		return NULL;
+	}
+
+	if (memcmp(header, "RIFF", 4) == 0) {
+		if (memcmp(header + 8, "WAVE", 4) == 0) {
+			return "audio/x-wav";
+		} else if (memcmp(header + 8, "WEBP", 4) == 0) {
+			return "image/webp";
+		}
+	} else if (memcmp(header, "FORM", 4) == 0) {
+		if ((memcmp(header + 8, "AIFF", 4) == 0) || (memcmp(header + 8, "AIFC", 4) == 0)) {
+			return "audio/x-aiff";
+		}
+	} else if (memcmp(header + 4, "ftyp", 4) == 0) { // ISO base media, only the audio brands are unambiguous
+		if ((memcmp(header + 8, "M4A ", 4) == 0) || (memcmp(header + 8, "M4B ", 4) == 0)) {
+			return "audio/mp4";
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Get the mimetype of a file, only falling back to libmagic when the extension and header bytes are not enough.
+ * The returned string is either static or owned by the provided cookie, so it must not be freed and is only valid until the cookie is used again.
+ **/
+const gchar * koto_mime_helpers_get_mimetype_for_file(
+	const gchar * path,
+	magic_t cookie
+) {
+	const gchar * mimetype = koto_mime_helpers_get_mimetype_for_extension(path);
+
+	if (mimetype != NULL) { // Known extension
+		g_atomic_int_inc(&koto_mime_tier_counts[KOTO_MIME_TIER_EXTENSION]);
+		return mimetype;
+	}
+
+	mimetype = koto_mime_helpers_get_mimetype_for_header(path);
+
+	if (mimetype != NULL) { // Recognized header
+		g_atomic_int_inc(&koto_mime_tier_counts[KOTO_MIME_TIER_HEADER]);
+		return mimetype;
+	}
+
+	mimetype = (cookie != NULL) ? magic_file(cookie, path) : NULL; // Ambiguous, so fall back to a full libmagic scan
+
+	g_atomic_int_inc(&koto_mime_tier_counts[(mimetype != NULL) ? KOTO_MIME_TIER_MAGIC : KOTO_MIME_TIER_UNKNOWN]);
+	return mimetype;
+}
+
+/**
+ * Get the libmagic cookie to use from the calling thread.
+ * Cookies are not thread-safe, so only the main thread uses our shared cookie and every other thread, such as indexer workers, gets its own.
+ **/
+magic_t koto_mime_helpers_get_magic_cookie() {
+	if (g_main_context_is_owner(g_main_context_default())) { // On the main thread
+		return magic_cookie;
+	}
+
+	magic_t cookie = g_private_get(&koto_mime_thread_magic_cookie);
+
+	if (cookie != NULL) { // Already have a cookie for this thread
+		return cookie;
+	}
+
+	cookie = magic_open(MAGIC_MIME);
+
+	if (cookie == NULL) { // Failed to open
+		g_critical("Failed to allocate a cookie pointer from libmagic for this thread.");
+		return NULL;
+	}
+
+	if (magic_load(cookie, NULL) != 0) { // Failed to load data
+		magic_close(cookie);
+		g_critical("Failed to load the system magic database for this thread.");
+		return NULL;
+	}
+
+	g_private_set(&koto_mime_thread_magic_cookie, cookie);
+	return cookie;
+}
+
+void koto_mime_helpers_get_tier_counts(guint counts[KOTO_MIME_TIER_COUNT]) {
+	for (guint i = 0; i < KOTO_MIME_TIER_COUNT; i++) { // For each tier
+		counts[i] = (guint) g_atomic_int_get(&koto_mime_tier_counts[i]);
+	}
+}
+
+void koto_mime_helpers_log_tier_counts(
+	const gchar * context,
+	guint since[KOTO_MIME_TIER_COUNT]
+) {
+	guint counts[KOTO_MIME_TIER_COUNT];
+	koto_mime_helpers_get_tier_counts(counts);
+
+	for (guint i = 0; i < KOTO_MIME_TIER_COUNT; i++) { // For each tier
+		counts[i] -= (since != NULL) ? since[i] : 0; // Only count what happened since the provided snapshot
+	}
+
+	guint total = counts[KOTO_MIME_TIER_EXTENSION] + counts[KOTO_MIME_TIER_HEADER] + counts[KOTO_MIME_TIER_MAGIC] + counts[KOTO_MIME_TIER_UNKNOWN];
+
+	if (total == 0) { // Nothing was classified
+		return;
+	}
+
+	g_message(
+		"Classified %u files while %s: %u by extension, %u by header, %u by libmagic (%.1f%%), %u unknown",
+		total,
+		context,
+		counts[KOTO_MIME_TIER_EXTENSION],
+		counts[KOTO_MIME_TIER_HEADER],
+		counts[KOTO_MIME_TIER_MAGIC],
+		(100.0 * counts[KOTO_MIME_TIER_MAGIC]) / total,
+		counts[KOTO_MIME_TIER_UNKNOWN]
+	);
+}
@@ -0,0 +1,42 @@
+/* mime-helpers.h
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <glib-2.0/glib.h>
+#include <magic.h>
+
+typedef enum {
+	KOTO_MIME_TIER_EXTENSION, // Decided by a known file extension
+	KOTO_MIME_TIER_HEADER, // Decided by the leading bytes of the file
+	KOTO_MIME_TIER_MAGIC, // Decided by libmagic
+	KOTO_MIME_TIER_UNKNOWN, // Nothing could classify the file
+	KOTO_MIME_TIER_COUNT
+} KotoMimeTier;
+
+magic_t koto_mime_helpers_get_magic_cookie();
+
+void koto_mime_helpers_get_tier_counts(guint counts[KOTO_MIME_TIER_COUNT]);
+
+const gchar * koto_mime_helpers_get_mimetype_for_file(
+	const gchar * path,
+	magic_t cookie
+);
+
+void koto_mime_helpers_log_tier_counts(
+	const gchar * context,
+	guint since[KOTO_MIME_TIER_COUNT]
+);
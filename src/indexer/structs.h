@@ -21,6 +21,7 @@
 #include <magic.h>
 #include <toml.h>
 #include "misc-types.h"
+#include "track-helpers.h"
 
 typedef enum {
 	KOTO_LIBRARY_TYPE_AUDIOBOOK = 1,
@@ -98,6 +99,8 @@ void koto_library_index(KotoLibrary * self);
 
 gboolean koto_library_is_available(KotoLibrary * self);
 
+void koto_library_reconcile(KotoLibrary * self);
+
 gchar * koto_library_get_storage_uuid(KotoLibrary * self);
 
 void koto_library_set_name(
@@ -117,21 +120,51 @@ void koto_library_set_storage_uuid(
 
 gchar * koto_library_to_config_string(KotoLibrary * self);
 
+void koto_library_watch(KotoLibrary * self);
+
 KotoLibraryType koto_library_type_from_string(gchar * t);
 
 gchar * koto_library_type_to_string(KotoLibraryType t);
 
+typedef struct _KotoIndexerChanges KotoIndexerChanges;
+
 void index_folder(
 	KotoLibrary * self,
 	gchar * path,
 	guint depth
 );
 
+void index_folder_parallel(
+	KotoLibrary * self,
+	gchar * path,
+	guint workers
+);
+
 void index_file(
 	KotoLibrary * lib,
 	const gchar * path
 );
 
+KotoIndexerChanges * index_changes_new(KotoLibrary * lib);
+
+void index_changes_apply(
+	KotoIndexerChanges * changes,
+	GSourceFunc done,
+	gpointer done_data
+);
+
+void index_changes_scan_library(KotoIndexerChanges * changes);
+
+void index_changes_scan_removal(
+	KotoIndexerChanges * changes,
+	const gchar * relative_path
+);
+
+void index_changes_scan_subtree(
+	KotoIndexerChanges * changes,
+	const gchar * relative_path
+);
+
 /**
  * Artist Functions
  **/
@@ -168,6 +201,8 @@ KotoAlbum * koto_artist_get_album_by_name(
 
 gchar * koto_artist_get_name(KotoArtist * self);
 
+const gchar * koto_artist_get_name_collation_key(KotoArtist * self);
+
 gchar * koto_artist_get_path(KotoArtist * self);
 
 GList * koto_artist_get_tracks(KotoArtist * self);
@@ -238,12 +273,12 @@ KotoLibraryType koto_album_get_lib_type(KotoAlbum * self);
 
 gchar * koto_album_get_name(KotoAlbum * self);
 
+const gchar * koto_album_get_name_collation_key(KotoAlbum * self);
+
 gchar * koto_album_get_narrator(KotoAlbum * self);
 
 gchar * koto_album_get_path(KotoAlbum * self);
 
-GListStore * koto_album_get_store(KotoAlbum * self);
-
 gchar * koto_album_get_uuid(KotoAlbum * self);
 
 guint64 koto_album_get_year(KotoAlbum * self);
@@ -332,6 +367,8 @@ gchar * koto_track_get_path(KotoTrack * self);
 
 gchar * koto_track_get_name(KotoTrack * self);
 
+const gchar * koto_track_get_name_collation_key(KotoTrack * self);
+
 gchar * koto_track_get_narrator(KotoTrack * self);
 
 guint64 koto_track_get_playback_position(KotoTrack * self);
@@ -384,6 +421,11 @@ void koto_track_set_genres(
 	char * genrelist
 );
 
+void koto_track_set_metadata(
+	KotoTrack * self,
+	KotoTrackMetadata * metadata
+);
+
 void koto_track_set_narrator(
 	KotoTrack * self,
 	const gchar * narrator
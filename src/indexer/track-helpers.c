@@ -16,13 +16,17 @@
  */
 
 #include <glib-2.0/glib.h>
+#include <string.h>
 #include <taglib/tag_c.h>
+#include "koto-config.h"
 #include  "../components/track-item.h"
 #include "../db/cartographer.h"
 #include "../koto-utils.h"
 #include "structs.h"
+#include "track-helpers.h"
 
 extern KotoCartographer * koto_maps;
+extern gchar * koto_path_art;
 
 GHashTable * genre_replacements;
 
@@ -76,20 +80,138 @@ guint64 koto_track_helpers_get_cd_based_on_file_name(const gchar * file_name) {
 	return cd;
 }
 
-gchar * koto_track_helpers_get_name_for_file(
-	const gchar * path,
-	gchar * optional_artist_name
+void koto_track_helpers_free_metadata(KotoTrackMetadata * metadata) {
+	if (metadata == NULL) {
+		return;
+	}
+
+	g_free(metadata->title);
+	g_free(metadata->artist);
+	g_free(metadata->album);
+	g_free(metadata->genres);
+	g_free(metadata->narrator);
+	g_free(metadata->description);
+	g_free(metadata->art_path);
+	g_free(metadata);
+}
+
+static gchar * koto_track_helpers_take_taglib_string(char * str) {
+	gchar * dup = koto_utils_string_is_valid(str) ? g_strdup(str) : NULL; // TagLib returns empty strings for unset fields
+	taglib_free(str); // Free the TagLib string
+	return dup;
+}
+
+#ifdef KOTO_TAGLIB_HAS_PROPERTIES
+static gchar * koto_track_helpers_get_property(
+	TagLib_File * t_file,
+	const char * property
 ) {
-	gchar * file_name = NULL;
-	TagLib_File * t_file = taglib_file_new(path); // Get a taglib file for this file
+	char ** values = taglib_property_get(t_file, property); // Get all values for this property
+	gchar * value = NULL;
+
+	if ((values != NULL) && koto_utils_string_is_valid(values[0])) { // Have a value
+		value = g_strdup(values[0]); // Only use the first value
+	}
+
+	taglib_property_free(values);
+	return value;
+}
+
+/**
+ * Save the first embedded picture of the file to our art store, returning its path. Pictures are named by the hash of their content, so art shared by every track of an album is only written once.
+ **/
+static gchar * koto_track_helpers_save_embedded_art(TagLib_File * t_file) {
+	TagLib_Complex_Property_Attribute *** props = taglib_complex_property_get(t_file, "PICTURE"); // Get any APIC / PICTURE blocks
+
+	if (props == NULL) { // No embedded pictures
+		return NULL;
+	}
+
+	TagLib_Complex_Property_Picture_Data picture;
+	memset(&picture, 0, sizeof(picture));
+	taglib_picture_from_complex_property(props, &picture); // Get the first picture
+
+	gchar * art_path = NULL;
+
+	if ((picture.data != NULL) && (picture.size > 0)) { // Have picture data
+		gchar * checksum = g_compute_checksum_for_data(G_CHECKSUM_SHA256, (const guchar*) picture.data, picture.size);
+		const gchar * ext = ((picture.mimeType != NULL) && (g_strcmp0(picture.mimeType, "image/png") == 0)) ? "png" : "jpg"; // APIC is nearly always JPEG or PNG
+		gchar * art_name = g_strdup_printf("%s.%s", checksum, ext);
+		art_path = g_build_filename(koto_path_art, art_name, NULL);
+
+		g_free(checksum);
+		g_free(art_name);
+
+		if (!g_file_test(art_path, G_FILE_TEST_EXISTS)) { // Not stored yet
+			GError * err = NULL;
+
+			if (!g_file_set_contents(art_path, picture.data, picture.size, &err)) { // Written aside and renamed, so concurrent workers never see a partial file
+				g_warning("Failed to save embedded art: %s", err->message);
+				g_error_free(err);
+				g_free(art_path);
+				art_path = NULL;
+			}
+		}
+	}
+
+	taglib_complex_property_free(props); // Picture data points into our properties, so only free once we are done with it
+	return art_path;
+}
+#endif
+
+KotoTrackMetadata * koto_track_helpers_get_metadata_for_file(const gchar * path) {
+	KotoTrackMetadata * metadata = g_new0(KotoTrackMetadata, 1);
+	TagLib_File * t_file = taglib_file_new(path); // Get a taglib file for this file, the only time we open it
 
 	if ((t_file != NULL) && taglib_file_is_valid(t_file)) { // If we got the taglib file and it is valid
 		TagLib_Tag * tag = taglib_file_tag(t_file); // Get our tag
-		file_name = g_strdup(taglib_tag_title(tag)); // Get the tag title and duplicate it
+
+		metadata->title = koto_track_helpers_take_taglib_string(taglib_tag_title(tag));
+		metadata->artist = koto_track_helpers_take_taglib_string(taglib_tag_artist(tag));
+		metadata->album = koto_track_helpers_take_taglib_string(taglib_tag_album(tag));
+		metadata->genres = koto_track_helpers_take_taglib_string(taglib_tag_genre(tag)); // Get any genres listed for the track
+		metadata->description = koto_track_helpers_take_taglib_string(taglib_tag_comment(tag));
+		metadata->position = (guint64) taglib_tag_track(tag);
+		metadata->year = (guint64) taglib_tag_year(tag);
+
+#ifdef KOTO_TAGLIB_HAS_PROPERTIES
+		gchar * disc = koto_track_helpers_get_property(t_file, "DISCNUMBER"); // Typically "1" or "1/2"
+
+		if (koto_utils_string_is_valid(disc)) {
+			metadata->disc = (guint) g_ascii_strtoull(disc, NULL, 10);
+		}
+
+		g_free(disc);
+		metadata->narrator = koto_track_helpers_get_property(t_file, "NARRATOR");
+		metadata->art_path = koto_track_helpers_save_embedded_art(t_file); // Extract while the file is still open
+#endif
+
+		const TagLib_AudioProperties * tag_props = taglib_file_audioproperties(t_file); // Get the audio properties of the file
+
+		if (tag_props != NULL) {
+			metadata->duration = (guint64) taglib_audioproperties_length(tag_props); // Get the length of the track
+		}
+	}
+
+	if (t_file != NULL) { // Have a taglib file
+		taglib_file_free(t_file); // Free the file
+	}
+
+	if (metadata->position == 0) { // Failed to get tag info or got the tag info but position is zero
+		gchar * basename = g_path_get_basename(path);
+		metadata->position = koto_track_helpers_get_position_based_on_file_name(basename); // Get the likely position
+		g_free(basename);
 	}
 
-	taglib_tag_free_strings(); // Free strings
-	taglib_file_free(t_file); // Free the file
+	return metadata;
+}
+
+gchar * koto_track_helpers_get_name_for_file(
+	const gchar * path,
+	gchar * optional_artist_name,
+	KotoTrackMetadata * metadata
+) {
+	gchar * file_name = (metadata != NULL) ? g_strdup(metadata->title) : NULL; // Prefer the title from the tag
 
 	if (koto_utils_string_is_valid(file_name)) { // File name not set yet
 		return file_name;
@@ -214,7 +336,7 @@ gint koto_track_helpers_sort_tracks(
 	guint track2_pos = koto_track_get_position(track2_real);
 
 	if (track1_pos == track2_pos) { // Identical positions (like reported as 0)
-		return g_utf8_collate(koto_track_get_name(track1_real), koto_track_get_name(track2_real));
+		return strcmp(koto_track_get_name_collation_key(track1_real), koto_track_get_name_collation_key(track2_real));
 	} else if (track1_pos < track2_pos) {
 		return -1;
 	} else {
@@ -15,17 +15,37 @@
  * limitations under the License.
  */
 
+#pragma once
 #include <glib-2.0/glib.h>
 
+typedef struct {
+	gchar * title;
+	gchar * artist;
+	gchar * album;
+	gchar * genres; // Semicolon separated, as provided by the tag
+	gchar * narrator;
+	gchar * description;
+	guint disc;
+	guint64 position;
+	guint64 year;
+	guint64 duration;
+	gchar * art_path; // Embedded picture saved to our art store, if the file has one
+} KotoTrackMetadata;
+
 void koto_track_helpers_init();
 
+void koto_track_helpers_free_metadata(KotoTrackMetadata * metadata);
+
+KotoTrackMetadata * koto_track_helpers_get_metadata_for_file(const gchar * path);
+
 guint64 koto_track_helpers_get_cd_based_on_file_name(const gchar * file_name);
 
 gchar * koto_track_helpers_get_corrected_genre(gchar * original_genre);
 
 gchar * koto_track_helpers_get_name_for_file(
 	const gchar * path,
-	gchar * optional_artist_name
+	gchar * optional_artist_name,
+	KotoTrackMetadata * metadata
 );
 
 guint64 koto_track_helpers_get_position_based_on_file_name(const gchar * file_name);
@@ -36,6 +36,7 @@ struct _KotoTrack {
 	GHashTable * paths;
 
 	gchar * parsed_name;
+	gchar * parsed_name_collation_key; // Precomputed so sorting by name does not collate on every comparison
 	guint cd;
 	guint64 position;
 	guint64 duration;
@@ -331,48 +332,33 @@ void koto_track_commit(KotoTrack * self) {
 		return;
 	}
 
-	gchar * commit_msg = "INSERT INTO tracks(id, artist_id, album_id, name, disc, position, duration, genres)" \
-						 "VALUES('%s', '%s', '%s', quote(\"%s\"), %d, %d, %d, '%s')" \
-						 "ON CONFLICT(id) DO UPDATE SET album_id=excluded.album_id, artist_id=excluded.artist_id, name=excluded.name, disc=excluded.disc, position=excluded.position, duration=excluded.duration, genres=excluded.genres;";
+	KotoDbWrite * write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_TRACK);
 
 	// Combine our list items into a semi-colon separated string
 	gchar * genres = koto_utils_join_string_list(self->genres, ";"); // Join our GList of strings into a single
 
-	gchar * commit_op = g_strdup_printf(
-		commit_msg,
-		self->uuid,
-		self->artist_uuid,
-		koto_utils_string_get_valid(self->album_uuid),
-		g_strescape(self->parsed_name, NULL),
-		(int) self->cd,
-		(int) self->position,
-		(int) self->duration,
-		genres
-	);
-
-	if (new_transaction(commit_op, "Failed to write our file to the database", FALSE) != SQLITE_OK) {
-		return;
-	}
+	koto_db_write_bind_text(write, 1, self->uuid);
+	koto_db_write_bind_text(write, 2, self->artist_uuid);
+	koto_db_write_bind_text(write, 3, koto_utils_string_get_valid(self->album_uuid));
+	koto_db_write_bind_text(write, 4, koto_utils_string_get_valid(self->parsed_name));
+	koto_db_write_bind_int64(write, 5, self->cd);
+	koto_db_write_bind_int64(write, 6, self->position);
+	koto_db_write_bind_int64(write, 7, self->duration);
+	koto_db_write_bind_text(write, 8, koto_utils_string_get_valid(genres));
 
+	koto_db_writer_push(write, "Failed to write our file to the database"); // Queued ahead of our paths, so the track exists by the time they are written
 	g_free(genres); // Free the genres string
 
 	GHashTableIter paths_iter;
 	g_hash_table_iter_init(&paths_iter, self->paths); // Create an iterator for our paths
 	gpointer lib_uuid_ptr, track_rel_path_ptr;
 	while (g_hash_table_iter_next(&paths_iter, &lib_uuid_ptr, &track_rel_path_ptr)) {
-		gchar * lib_uuid = lib_uuid_ptr;
-		gchar * track_rel_path = track_rel_path_ptr;
-
-		gchar * commit_op = g_strdup_printf(
-			"INSERT INTO libraries_tracks(id, track_id, path)"
-			"VALUES ('%s', '%s', quote(\"%s\"))"
-			"ON CONFLICT(id, track_id) DO UPDATE SET path=excluded.path;",
-			lib_uuid,
-			self->uuid,
-			track_rel_path
-		);
+		KotoDbWrite * path_write = koto_db_writer_new_write(KOTO_DB_STATEMENT_UPSERT_TRACK_PATH);
 
-		new_transaction(commit_op, "Failed to add this path for the track", FALSE);
+		koto_db_write_bind_text(path_write, 1, lib_uuid_ptr);
+		koto_db_write_bind_text(path_write, 2, self->uuid);
+		koto_db_write_bind_text(path_write, 3, track_rel_path_ptr);
+		koto_db_writer_push(path_write, "Failed to add this path for the track");
 	}
 }
 
@@ -445,6 +431,14 @@ gchar * koto_track_get_name(KotoTrack * self) {
 	return KOTO_IS_TRACK(self) ? g_strdup(self->parsed_name) : NULL;
 }
 
+const gchar * koto_track_get_name_collation_key(KotoTrack * self) {
+	if (!KOTO_IS_TRACK(self) || (self->parsed_name_collation_key == NULL)) { // Not a track or no name yet
+		return "";
+	}
+
+	return self->parsed_name_collation_key;
+}
+
 gchar * koto_track_get_narrator(KotoTrack * self) {
 	return KOTO_IS_TRACK(self) ? g_strdup(self->narrator) : NULL;
 }
@@ -483,27 +477,18 @@ guint64 koto_track_get_position(KotoTrack * self) {
 }
 
 gchar * koto_track_get_uniqueish_key(KotoTrack * self) {
-	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, self->artist_uuid); // Get the artist associated with this track
-
-	if (!KOTO_IS_ARTIST(artist)) { // Don't have an artist
-		return g_strdup(self->parsed_name); // Just return the name of the file, which is very likely not unique
+	if (!KOTO_IS_TRACK(self)) {
+		return NULL;
 	}
 
-	gchar * artist_name = koto_artist_get_name(artist); // Get the artist name
-
-	if (koto_utils_string_is_valid(self->album_uuid)) { // If we have an album associated with this track (not necessarily guaranteed)
-		KotoAlbum * possible_album = koto_cartographer_get_album_by_uuid(koto_maps, self->album_uuid);
-
-		if (KOTO_IS_ALBUM(possible_album)) { // Album exists
-			gchar * album_name = koto_album_get_name(possible_album); // Get the name of the album
+	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, self->artist_uuid); // Get the artist associated with this track
+	KotoAlbum * album = koto_utils_string_is_valid(self->album_uuid) ? koto_cartographer_get_album_by_uuid(koto_maps, self->album_uuid) : NULL; // Get any album associated with this track (not necessarily guaranteed)
 
-			if (koto_utils_string_is_valid(album_name)) {
-				return g_strdup_printf("%s-%s-%s", artist_name, album_name, self->parsed_name); // Create a key of (ARTIST/WRITER)-(ALBUM/AUDIOBOOK)-(CHAPTER/TRACK)
-			}
-		}
-	}
+	gchar * artist_name = KOTO_IS_ARTIST(artist) ? koto_artist_get_name(artist) : NULL;
+	gchar * key = koto_cartographer_build_uniqueish_key(artist_name, KOTO_IS_ALBUM(album) ? koto_album_get_name(album) : NULL, self->parsed_name); // Key of (ARTIST/WRITER)-(ALBUM/AUDIOBOOK)-(CHAPTER/TRACK)
+	g_free(artist_name);
 
-	return g_strdup_printf("%s-%s", artist_name, self->parsed_name); // Create a key of just (ARTIST/WRITER)-(CHAPTER/TRACK)
+	return key;
 }
 
 gchar * koto_track_get_uuid(KotoTrack * self) {
@@ -721,6 +706,9 @@ void koto_track_set_parsed_name(
 	}
 
 	self->parsed_name = g_strdup(new_parsed_name);
+
+	g_free(self->parsed_name_collation_key);
+	self->parsed_name_collation_key = g_utf8_collate_key(new_parsed_name, -1); // Rebuild our collation key for the new name
 	g_object_notify_by_pspec(G_OBJECT(self), props[PROP_PARSED_NAME]);
 }
 
@@ -798,25 +786,36 @@ void koto_track_update_metadata(KotoTrack * self) {
 		return;
 	}
 
-	TagLib_File * t_file = taglib_file_new(optimal_track_path); // Get a taglib file for this file
+	KotoTrackMetadata * metadata = koto_track_helpers_get_metadata_for_file(optimal_track_path); // Attempt to get ID3 info
+	koto_track_set_metadata(self, metadata);
+	koto_track_helpers_free_metadata(metadata);
+	g_free(optimal_track_path);
+}
 
-	if ((t_file != NULL) && taglib_file_is_valid(t_file)) { // If we got the taglib file and it is valid
-		TagLib_Tag * tag = taglib_file_tag(t_file); // Get our tag
-		koto_track_set_genres(self, taglib_tag_genre(tag)); // Set our genres to any genres listed for the track
-		koto_track_set_position(self, (uint) taglib_tag_track(tag)); // Get the track, convert to uint and cast as a pointer
-		koto_track_set_year(self, (guint64) taglib_tag_year(tag)); // Get the track year and convert it to guint64
-		const TagLib_AudioProperties * tag_props = taglib_file_audioproperties(t_file); // Get the audio properties of the file
-		koto_track_set_duration(self, taglib_audioproperties_length(tag_props)); // Get the length of the track and set it as our duration
+void koto_track_set_metadata(
+	KotoTrack * self,
+	KotoTrackMetadata * metadata
+) {
+	if (!KOTO_IS_TRACK(self)) { // Not a track
+		return;
 	}
 
-	if (self->position == 0) { // Failed to get tag info or got the tag info but position is zero
-		guint64 position = koto_track_helpers_get_position_based_on_file_name(g_path_get_basename(optimal_track_path)); // Get the likely position
-		koto_track_set_position(self, position); // Set our position
+	if (metadata == NULL) { // No metadata
+		return;
 	}
 
-	taglib_tag_free_strings(); // Free strings
-	taglib_file_free(t_file); // Free the file
-	g_free(optimal_track_path);
+	self->do_initial_index = FALSE; // Already have our metadata, so setting a path does not need to read the file again
+
+	koto_track_set_genres(self, metadata->genres); // Set our genres
+	koto_track_set_position(self, metadata->position);
+	koto_track_set_year(self, metadata->year);
+	koto_track_set_duration(self, metadata->duration); // Set the length of the track as our duration
+	koto_track_set_narrator(self, metadata->narrator);
+	koto_track_set_description(self, metadata->description);
+
+	if (metadata->disc != 0) { // Tag has a disc number
+		koto_track_set_cd(self, metadata->disc);
+	}
 }
 
 void koto_track_set_preparsed_genres(
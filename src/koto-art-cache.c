@@ -0,0 +1,435 @@
+/* koto-art-cache.c
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib-2.0/glib.h>
+#include <glib-2.0/glib/gstdio.h>
+#include <gtk-4.0/gtk/gtk.h>
+#include "db/cartographer.h"
+#include "indexer/structs.h"
+#include "playlist/playlist.h"
+#include "koto-art-cache.h"
+#include "koto-utils.h"
+
+#define KOTO_ART_CACHE_IMAGE_KEY "koto-art-cache-key"
+#define KOTO_ART_CACHE_MAX_BYTES (64 * 1024 * 1024) // Decoded textures we keep around before evicting the least recently used
+#define KOTO_ART_CACHE_THUMBNAIL_SIZE 220 // Size our album and playlist covers are shown at, which we generate thumbnails for ahead of time
+
+extern KotoCartographer * koto_maps;
+extern gchar * koto_path_thumbnails;
+
+typedef struct {
+	gchar * key;
+	GdkTexture * texture;
+	gsize bytes;
+	GList * link; // Our link in the LRU queue
+} KotoArtCacheEntry;
+
+typedef struct {
+	gchar * key;
+	gchar * path;
+	guint width;
+	guint height;
+	GPtrArray * images; // GWeakRefs of the GtkImages waiting on this decode
+} KotoArtCacheRequest;
+
+typedef struct {
+	gchar * path;
+	guint width;
+	guint height;
+} KotoArtCacheThumbnailJob;
+
+struct _KotoArtCache {
+	GObject parent_instance;
+
+	GHashTable * entries; // Key of path and size to KotoArtCacheEntry
+	GQueue * lru; // KotoArtCacheEntry, most recently used at the head
+	gsize bytes;
+
+	GHashTable * pending; // Key of path and size to KotoArtCacheRequest being decoded
+
+	GThreadPool * thumbnailer; // Single low priority worker generating thumbnails after indexing
+	gint scale; // Last scale factor we decoded for, so generated thumbnails match what widgets will ask for
+
+	gint thumbnail_hits; // Loads served from our on-disk thumbnails, updated atomically from workers
+	gint thumbnail_misses; // Loads that had to decode the original artwork
+};
+
+struct _KotoArtCacheClass {
+	GObjectClass parent_class;
+};
+
+G_DEFINE_TYPE(KotoArtCache, koto_art_cache, G_TYPE_OBJECT);
+
+KotoArtCache * koto_art_cache;
+
+static void koto_art_cache_entry_free(gpointer data) {
+	KotoArtCacheEntry * entry = data;
+
+	g_free(entry->key);
+	g_object_unref(entry->texture);
+	g_free(entry);
+}
+
+static void koto_art_cache_weak_ref_free(gpointer data) {
+	GWeakRef * ref = data;
+
+	g_weak_ref_clear(ref);
+	g_free(ref);
+}
+
+static void koto_art_cache_request_free(gpointer data) {
+	KotoArtCacheRequest * request = data;
+
+	g_free(request->key);
+	g_free(request->path);
+	g_ptr_array_free(request->images, TRUE);
+	g_free(request);
+}
+
+static void koto_art_cache_generate_thumbnail(
+	gpointer data,
+	gpointer user_data
+);
+
+static void koto_art_cache_class_init(KotoArtCacheClass * c) {
+	(void) c;
+}
+
+static void koto_art_cache_init(KotoArtCache * self) {
+	self->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, koto_art_cache_entry_free); // Entries own their key
+	self->lru = g_queue_new();
+	self->bytes = 0;
+	self->pending = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, koto_art_cache_request_free); // Requests own their key
+	self->thumbnailer = g_thread_pool_new(koto_art_cache_generate_thumbnail, self, 1, FALSE, NULL);
+	self->scale = 1;
+	self->thumbnail_hits = 0;
+	self->thumbnail_misses = 0;
+
+	g_signal_connect(koto_maps, "albums-added", G_CALLBACK(koto_art_cache_handle_albums_added), self); // Covers found while indexing or loading
+	g_signal_connect(koto_maps, "playlist-added", G_CALLBACK(koto_art_cache_handle_playlist_added), self);
+}
+
+static gchar * koto_art_cache_get_thumbnail_path(
+	const gchar * path,
+	guint width,
+	guint height
+) {
+	GStatBuf source_stat;
+
+	if (g_stat(path, &source_stat) != 0) { // Source is gone
+		return NULL;
+	}
+
+	gchar * thumbnail_key = g_strdup_printf("%s\n%" G_GINT64_FORMAT "\n%ux%u", path, (gint64) source_stat.st_mtime, width, height); // A changed file or size gets a new thumbnail
+	gchar * checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, thumbnail_key, -1);
+	gchar * thumbnail_name = g_strdup_printf("%s.png", checksum);
+	gchar * thumbnail_path = g_build_filename(koto_path_thumbnails, thumbnail_name, NULL);
+
+	g_free(thumbnail_key);
+	g_free(checksum);
+	g_free(thumbnail_name);
+	return thumbnail_path;
+}
+
+static GdkPixbuf * koto_art_cache_decode_and_save_thumbnail(
+	const gchar * path,
+	const gchar * thumbnail_path,
+	guint width,
+	guint height,
+	GError ** err
+) {
+	GdkPixbuf * pixbuf = gdk_pixbuf_new_from_file_at_scale(path, width, height, TRUE, err); // Loaders downscale as they decode, so we never hold the full resolution image
+
+	if ((pixbuf == NULL) || (thumbnail_path == NULL)) { // Failed to decode or nowhere to save
+		return pixbuf;
+	}
+
+	gchar * tmp_path = g_strdup_printf("%s.%p.tmp", thumbnail_path, (void*) g_thread_self()); // Write aside and rename, so a reader never sees a partial file
+	GError * save_err = NULL;
+
+	if (gdk_pixbuf_save(pixbuf, tmp_path, "png", &save_err, NULL)) { // Saved
+		g_rename(tmp_path, thumbnail_path);
+	} else {
+		g_warning("Failed to save thumbnail for %s: %s", path, save_err->message);
+		g_error_free(save_err);
+		g_unlink(tmp_path);
+	}
+
+	g_free(tmp_path);
+	return pixbuf;
+}
+
+static void koto_art_cache_generate_thumbnail(
+	gpointer data,
+	gpointer user_data
+) {
+	(void) user_data;
+	KotoArtCacheThumbnailJob * job = data;
+	gchar * thumbnail_path = koto_art_cache_get_thumbnail_path(job->path, job->width, job->height);
+
+	if ((thumbnail_path != NULL) && !g_file_test(thumbnail_path, G_FILE_TEST_EXISTS)) { // Have a source without a thumbnail
+		GError * err = NULL;
+		GdkPixbuf * pixbuf = koto_art_cache_decode_and_save_thumbnail(job->path, thumbnail_path, job->width, job->height, &err);
+
+		if (pixbuf != NULL) {
+			g_object_unref(pixbuf);
+		} else {
+			g_error_free(err); // Nothing is waiting on this, so a broken image only matters when it is shown
+		}
+	}
+
+	g_free(thumbnail_path);
+	g_free(job->path);
+	g_free(job);
+}
+
+static void koto_art_cache_add_waiting_image(
+	KotoArtCacheRequest * request,
+	GtkImage * image
+) {
+	GWeakRef * ref = g_new0(GWeakRef, 1);
+
+	g_weak_ref_init(ref, image); // Widgets can go away before we finish decoding
+	g_ptr_array_add(request->images, ref);
+}
+
+static void koto_art_cache_evict(KotoArtCache * self) {
+	while ((self->bytes > KOTO_ART_CACHE_MAX_BYTES) && (g_queue_get_length(self->lru) > 1)) { // Over budget, always keeping the texture we just added
+		KotoArtCacheEntry * entry = g_queue_pop_tail(self->lru); // Least recently used
+		self->bytes -= entry->bytes;
+		g_hash_table_remove(self->entries, entry->key); // Images still showing the texture keep their own reference
+	}
+}
+
+static void koto_art_cache_decode(
+	GTask * task,
+	gpointer source_object,
+	gpointer task_data,
+	GCancellable * cancellable
+) {
+	(void) cancellable;
+	KotoArtCacheRequest * request = task_data;
+	KotoArtCache * self = KOTO_ART_CACHE(source_object);
+	GError * err = NULL;
+	GdkPixbuf * pixbuf = NULL;
+
+	if ((request->width != 0) && (request->height != 0)) { // Have a size to decode to, which is what we keep thumbnails of
+		gchar * thumbnail_path = koto_art_cache_get_thumbnail_path(request->path, request->width, request->height);
+
+		if ((thumbnail_path != NULL) && g_file_test(thumbnail_path, G_FILE_TEST_EXISTS)) { // Have a thumbnail for this version of the file
+			pixbuf = gdk_pixbuf_new_from_file(thumbnail_path, NULL);
+		}
+
+		if (pixbuf != NULL) { // Loaded our thumbnail
+			g_atomic_int_inc(&self->thumbnail_hits);
+		} else { // No usable thumbnail, so decode the original and keep a thumbnail of it
+			g_atomic_int_inc(&self->thumbnail_misses);
+			pixbuf = koto_art_cache_decode_and_save_thumbnail(request->path, thumbnail_path, request->width, request->height, &err);
+		}
+
+		g_free(thumbnail_path);
+	} else {
+		pixbuf = gdk_pixbuf_new_from_file(request->path, &err);
+	}
+
+	if (pixbuf == NULL) { // Failed to decode
+		g_task_return_error(task, err);
+		return;
+	}
+
+	g_task_return_pointer(task, pixbuf, g_object_unref);
+}
+
+static void koto_art_cache_handle_decoded(
+	GObject * source_object,
+	GAsyncResult * res,
+	gpointer user_data
+) {
+	(void) user_data;
+	KotoArtCache * self = KOTO_ART_CACHE(source_object);
+	KotoArtCacheRequest * request = g_task_get_task_data(G_TASK(res));
+	GError * err = NULL;
+	GdkPixbuf * pixbuf = g_task_propagate_pointer(G_TASK(res), &err);
+
+	if (pixbuf == NULL) { // Failed to decode, so our images keep their placeholder
+		g_warning("Failed to load artwork %s: %s", request->path, err->message);
+		g_error_free(err);
+		g_hash_table_remove(self->pending, request->key);
+		return;
+	}
+
+	KotoArtCacheEntry * entry = g_new0(KotoArtCacheEntry, 1);
+	entry->key = g_strdup(request->key);
+	entry->texture = gdk_texture_new_for_pixbuf(pixbuf);
+	entry->bytes = (gsize) gdk_pixbuf_get_rowstride(pixbuf) * gdk_pixbuf_get_height(pixbuf);
+	g_object_unref(pixbuf);
+
+	g_queue_push_head(self->lru, entry);
+	entry->link = self->lru->head;
+	self->bytes += entry->bytes;
+	g_hash_table_replace(self->entries, entry->key, entry);
+
+	for (guint i = 0; i < request->images->len; i++) { // For each image waiting on this texture
+		GtkImage * image = g_weak_ref_get(g_ptr_array_index(request->images, i));
+
+		if (image == NULL) { // Image went away
+			continue;
+		}
+
+		if (g_strcmp0(g_object_get_data(G_OBJECT(image), KOTO_ART_CACHE_IMAGE_KEY), request->key) == 0) { // Still wants this artwork rather than something requested since
+			gtk_image_set_from_paintable(image, GDK_PAINTABLE(entry->texture));
+		}
+
+		g_object_unref(image);
+	}
+
+	g_hash_table_remove(self->pending, request->key);
+	koto_art_cache_evict(self);
+}
+
+void koto_art_cache_set_image(
+	KotoArtCache * self,
+	GtkImage * image,
+	const gchar * path,
+	guint width,
+	guint height,
+	const gchar * fallback_icon
+) {
+	if (!KOTO_IS_ART_CACHE(self)) {
+		return;
+	}
+
+	if (!GTK_IS_IMAGE(image)) {
+		return;
+	}
+
+	if (!koto_utils_string_is_valid(path)) { // No artwork
+		g_object_set_data(G_OBJECT(image), KOTO_ART_CACHE_IMAGE_KEY, NULL); // Forget any artwork still decoding for this image
+		(fallback_icon != NULL) ? gtk_image_set_from_icon_name(image, fallback_icon) : gtk_image_clear(image);
+		return;
+	}
+
+	gint scale = gtk_widget_get_scale_factor(GTK_WIDGET(image)); // Decode at device pixels so HiDPI does not upscale
+	self->scale = scale;
+	guint decode_width = width * scale;
+	guint decode_height = height * scale;
+	gchar * key = g_strdup_printf("%s:%ux%u", path, decode_width, decode_height);
+
+	g_object_set_data_full(G_OBJECT(image), KOTO_ART_CACHE_IMAGE_KEY, g_strdup(key), g_free); // Remember what this image wants, so stale decodes are ignored
+
+	KotoArtCacheEntry * entry = g_hash_table_lookup(self->entries, key);
+
+	if (entry != NULL) { // Already decoded
+		g_queue_unlink(self->lru, entry->link);
+		g_queue_push_head_link(self->lru, entry->link); // Now the most recently used
+		gtk_image_set_from_paintable(image, GDK_PAINTABLE(entry->texture));
+		g_free(key);
+		return;
+	}
+
+	(fallback_icon != NULL) ? gtk_image_set_from_icon_name(image, fallback_icon) : gtk_image_clear(image); // Placeholder until our texture is ready
+
+	KotoArtCacheRequest * request = g_hash_table_lookup(self->pending, key);
+
+	if (request != NULL) { // Already decoding this path at this size
+		koto_art_cache_add_waiting_image(request, image);
+		g_free(key);
+		return;
+	}
+
+	request = g_new0(KotoArtCacheRequest, 1);
+	request->key = key;
+	request->path = g_strdup(path);
+	request->width = decode_width;
+	request->height = decode_height;
+	request->images = g_ptr_array_new_with_free_func(koto_art_cache_weak_ref_free);
+	koto_art_cache_add_waiting_image(request, image);
+	g_hash_table_replace(self->pending, request->key, request);
+
+	GTask * task = g_task_new(self, NULL, koto_art_cache_handle_decoded, NULL);
+	g_task_set_task_data(task, request, NULL); // Owned by our pending table
+	g_task_run_in_thread(task, koto_art_cache_decode);
+	g_object_unref(task);
+}
+
+void koto_art_cache_handle_albums_added(
+	KotoCartographer * carto,
+	GPtrArray * albums,
+	gpointer user_data
+) {
+	(void) carto;
+	KotoArtCache * self = user_data;
+
+	for (guint i = 0; i < albums->len; i++) { // For each album added in this batch
+		gchar * art_path = koto_album_get_art(g_ptr_array_index(albums, i));
+		koto_art_cache_prepare_thumbnail(self, art_path, KOTO_ART_CACHE_THUMBNAIL_SIZE, KOTO_ART_CACHE_THUMBNAIL_SIZE);
+		g_free(art_path);
+	}
+}
+
+void koto_art_cache_handle_playlist_added(
+	KotoCartographer * carto,
+	KotoPlaylist * playlist,
+	gpointer user_data
+) {
+	(void) carto;
+	KotoArtCache * self = user_data;
+	gchar * art_path = koto_playlist_get_artwork(playlist);
+
+	koto_art_cache_prepare_thumbnail(self, art_path, KOTO_ART_CACHE_THUMBNAIL_SIZE, KOTO_ART_CACHE_THUMBNAIL_SIZE);
+	g_free(art_path);
+}
+
+void koto_art_cache_log_thumbnail_stats(KotoArtCache * self) {
+	if (!KOTO_IS_ART_CACHE(self)) {
+		return;
+	}
+
+	gint hits = g_atomic_int_get(&self->thumbnail_hits);
+	gint misses = g_atomic_int_get(&self->thumbnail_misses);
+
+	if ((hits + misses) == 0) { // Did not show any artwork
+		return;
+	}
+
+	g_message("Loaded artwork from %d thumbnails and %d originals (%.1f%% thumbnail hit rate)", hits, misses, (100.0 * hits) / (hits + misses));
+}
+
+void koto_art_cache_prepare_thumbnail(
+	KotoArtCache * self,
+	const gchar * path,
+	guint width,
+	guint height
+) {
+	if (!KOTO_IS_ART_CACHE(self)) {
+		return;
+	}
+
+	if (!koto_utils_string_is_valid(path)) { // No artwork
+		return;
+	}
+
+	KotoArtCacheThumbnailJob * job = g_new0(KotoArtCacheThumbnailJob, 1);
+	job->path = g_strdup(path);
+	job->width = width * self->scale;
+	job->height = height * self->scale;
+	g_thread_pool_push(self->thumbnailer, job, NULL); // Checking for an existing thumbnail stats the file, so leave that to our worker too
+}
+
+KotoArtCache * koto_art_cache_new() {
+	return g_object_new(KOTO_TYPE_ART_CACHE, NULL);
+}
@@ -0,0 +1,64 @@
+/* koto-art-cache.h
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <glib-2.0/glib-object.h>
+#include <gtk-4.0/gtk/gtk.h>
+#include "db/cartographer.h"
+#include "indexer/structs.h"
+#include "playlist/playlist.h"
+
+G_BEGIN_DECLS
+
+#define KOTO_TYPE_ART_CACHE (koto_art_cache_get_type())
+G_DECLARE_FINAL_TYPE(KotoArtCache, koto_art_cache, KOTO, ART_CACHE, GObject)
+#define KOTO_IS_ART_CACHE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), KOTO_TYPE_ART_CACHE))
+
+KotoArtCache * koto_art_cache_new();
+
+void koto_art_cache_handle_albums_added(
+	KotoCartographer * carto,
+	GPtrArray * albums,
+	gpointer user_data
+);
+
+void koto_art_cache_handle_playlist_added(
+	KotoCartographer * carto,
+	KotoPlaylist * playlist,
+	gpointer user_data
+);
+
+void koto_art_cache_log_thumbnail_stats(KotoArtCache * self);
+
+void koto_art_cache_prepare_thumbnail(
+	KotoArtCache * self,
+	const gchar * path,
+	guint width,
+	guint height
+);
+
+void koto_art_cache_set_image(
+	KotoArtCache * self,
+	GtkImage * image,
+	const gchar * path,
+	guint width,
+	guint height,
+	const gchar * fallback_icon
+);
+
+G_END_DECLS
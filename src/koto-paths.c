@@ -25,6 +25,8 @@
 gchar * koto_rev_dns;
 gchar * koto_path_cache;
 gchar * koto_path_config;
+gchar * koto_path_thumbnails;
+gchar * koto_path_art;
 
 gchar * koto_path_to_conf;
 gchar * koto_path_to_db;
@@ -38,9 +40,13 @@ void koto_paths_setup() {
 	koto_path_config = g_build_path(G_DIR_SEPARATOR_S, user_config_dir, koto_rev_dns, NULL);
 	koto_path_to_conf = g_build_filename(koto_path_config, "config.toml", NULL);
 	koto_path_to_db = g_build_filename( koto_path_cache, "db", NULL);
+	koto_path_thumbnails = g_build_path(G_DIR_SEPARATOR_S, koto_path_cache, "thumbnails", NULL);
+	koto_path_art = g_build_path(G_DIR_SEPARATOR_S, koto_path_cache, "art", NULL);
 
 	koto_utils_mkdir(user_cache_dir);
 	koto_utils_mkdir(user_config_dir);
 	koto_utils_mkdir(koto_path_cache);
 	koto_utils_mkdir(koto_path_config);
+	koto_utils_mkdir(koto_path_thumbnails);
+	koto_utils_mkdir(koto_path_art);
 }
\ No newline at end of file
@@ -25,10 +25,12 @@
 #include "playlist/playlist.h"
 #include "playback/engine.h"
 #include "config/config.h"
+#include "koto-art-cache.h"
 #include "koto-playerbar.h"
 #include "koto-utils.h"
 
 extern KotoAddRemoveTrackPopover * koto_add_remove_track_popup;
+extern KotoArtCache * koto_art_cache;
 extern KotoCartographer * koto_maps;
 extern KotoConfig * config;
 extern KotoCurrentPlaylist * current_playlist;
@@ -74,7 +76,11 @@ struct _KotoPlayerBar {
 	GtkWidget * playback_position_label;
 
 	gint64 last_recorded_duration;
+	gint64 last_label_position; // Second shown in our position label, so we only rewrite it when it changes
+	gint64 last_label_duration;
+	guint progress_tick_id; // Frame clock callback, only present while we are mapped and playing
 
+	gboolean is_playing;
 	gboolean is_progressbar_seeking;
 };
 
@@ -143,6 +149,8 @@ static void koto_playerbar_constructed(GObject * obj) {
 	gtk_box_append(GTK_BOX(self->main), self->controls);
 
 	gtk_widget_set_hexpand(GTK_WIDGET(self->main), TRUE);
+	g_signal_connect(self->main, "map", G_CALLBACK(koto_playerbar_handle_main_map), self); // Only follow playback progress while we can be seen
+	g_signal_connect(self->main, "unmap", G_CALLBACK(koto_playerbar_handle_main_unmap), self);
 
 	// Set up our volume and other playback state bits from our config
 
@@ -162,6 +170,10 @@ static void koto_playerbar_constructed(GObject * obj) {
 
 static void koto_playerbar_init(KotoPlayerBar * self) {
 	self->last_recorded_duration = 0;
+	self->last_label_position = -1;
+	self->last_label_duration = -1;
+	self->progress_tick_id = 0;
+	self->is_playing = FALSE;
 	self->is_progressbar_seeking = FALSE;
 }
 
@@ -353,6 +365,23 @@ void koto_playerbar_go_forwards(
 	koto_playback_engine_forwards(playback_engine);
 }
 
+gboolean koto_playerbar_handle_progress_tick(
+	GtkWidget * progress_bar,
+	GdkFrameClock * frame_clock,
+	gpointer user_data
+) {
+	(void) progress_bar;
+	(void) frame_clock;
+	KotoPlayerBar * self = user_data;
+
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return G_SOURCE_REMOVE;
+	}
+
+	koto_playerbar_refresh_progress(self);
+	return G_SOURCE_CONTINUE;
+}
+
 void koto_playerbar_handle_speed_input_activate(
 	GtkEntry * playback_speed_input,
 	gpointer user_data
@@ -391,6 +420,8 @@ void koto_playerbar_handle_is_playing(
 	}
 
 	koto_button_show_image(self->play_pause_button, TRUE); // Set to TRUE to show pause as the next action
+	self->is_playing = TRUE;
+	koto_playerbar_start_progress_tick(self);
 }
 
 void koto_playerbar_handle_is_paused(
@@ -408,6 +439,38 @@ void koto_playerbar_handle_is_paused(
 	}
 
 	koto_button_show_image(self->play_pause_button, FALSE); // Set to FALSE to show play as the next action
+	self->is_playing = FALSE;
+	koto_playerbar_stop_progress_tick(self);
+	koto_playerbar_refresh_progress(self); // Settle on where we paused
+}
+
+void koto_playerbar_handle_main_map(
+	GtkWidget * main,
+	gpointer user_data
+) {
+	(void) main;
+	KotoPlayerBar * self = user_data;
+
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return;
+	}
+
+	koto_playerbar_refresh_progress(self); // Catch up on anything we missed while unmapped
+	koto_playerbar_start_progress_tick(self);
+}
+
+void koto_playerbar_handle_main_unmap(
+	GtkWidget * main,
+	gpointer user_data
+) {
+	(void) main;
+	KotoPlayerBar * self = user_data;
+
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return;
+	}
+
+	koto_playerbar_stop_progress_tick(self);
 }
 
 void koto_playerbar_handle_playlist_button_clicked(
@@ -532,21 +595,7 @@ void koto_playerbar_handle_tick_track(
 		return;
 	}
 
-	if (self->is_progressbar_seeking) { // Currently seeking
-		return;
-	}
-
-	KotoTrack * current_track = koto_playback_engine_get_current_track(engine);
-
-	gtk_label_set_text(
-		GTK_LABEL(self->playback_position_label),
-		g_strdup_printf(
-			"%s / %s",
-			koto_utils_seconds_to_time_format(koto_track_get_playback_position(current_track)),
-			koto_utils_seconds_to_time_format(koto_track_get_duration(current_track))
-	));
-
-	koto_playerbar_set_progressbar_value(self, koto_playback_engine_get_progress(engine));
+	koto_playerbar_refresh_progress(self); // Position jumped, so catch up even if our frame clock is not running
 }
 
 void koto_playerbar_handle_track_repeat(
@@ -633,6 +682,46 @@ void koto_playerbar_jump_forwards(
 	koto_playback_engine_jump_forwards(playback_engine);
 }
 
+void koto_playerbar_refresh_progress(KotoPlayerBar * self) {
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return;
+	}
+
+	if (self->is_progressbar_seeking) { // Currently seeking
+		return;
+	}
+
+	KotoTrack * current_track = koto_playback_engine_get_current_track(playback_engine);
+
+	if (!KOTO_IS_TRACK(current_track)) { // Nothing to show progress for
+		return;
+	}
+
+	gdouble progress = koto_playback_engine_get_progress(playback_engine); // Whole seconds
+	gint64 duration = (gint64) koto_track_get_duration(current_track);
+
+	if (gtk_range_get_value(GTK_RANGE(self->progress_bar)) != progress) { // Moved on to another second
+		koto_playerbar_set_progressbar_value(self, progress);
+	}
+
+	if (((gint64) progress == self->last_label_position) && (duration == self->last_label_duration)) { // Label would read the same
+		return;
+	}
+
+	self->last_label_position = (gint64) progress;
+	self->last_label_duration = duration;
+
+	gchar * position_str = koto_utils_seconds_to_time_format((guint64) progress);
+	gchar * duration_str = koto_utils_seconds_to_time_format((guint64) duration);
+	gchar * label = g_strdup_printf("%s / %s", position_str, duration_str);
+
+	gtk_label_set_text(GTK_LABEL(self->playback_position_label), label);
+
+	g_free(position_str);
+	g_free(duration_str);
+	g_free(label);
+}
+
 void koto_playerbar_reset_progressbar(KotoPlayerBar * self) {
 	if (!KOTO_IS_PLAYERBAR(self)) {
 		return;
@@ -683,6 +772,31 @@ void koto_playerbar_set_progressbar_value(
 	gtk_range_set_value(GTK_RANGE(self->progress_bar), progress);
 }
 
+void koto_playerbar_start_progress_tick(KotoPlayerBar * self) {
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return;
+	}
+
+	if ((self->progress_tick_id != 0) || !self->is_playing || !gtk_widget_get_mapped(self->main)) { // Already ticking, paused or not visible
+		return;
+	}
+
+	self->progress_tick_id = gtk_widget_add_tick_callback(self->progress_bar, koto_playerbar_handle_progress_tick, self, NULL); // Frame clock stops with the window, unlike a timeout
+}
+
+void koto_playerbar_stop_progress_tick(KotoPlayerBar * self) {
+	if (!KOTO_IS_PLAYERBAR(self)) {
+		return;
+	}
+
+	if (self->progress_tick_id == 0) { // Not ticking
+		return;
+	}
+
+	gtk_widget_remove_tick_callback(self->progress_bar, self->progress_tick_id);
+	self->progress_tick_id = 0;
+}
+
 void koto_playerbar_toggle_play_pause(
 	GtkGestureClick * gesture,
 	int n_press,
@@ -797,11 +911,9 @@ void koto_playerbar_update_track_info(
 
 	(set_album_label) ? gtk_widget_show(self->playback_album) : gtk_widget_hide(self->playback_album);
 
-	if ((art_path != NULL) && g_path_is_absolute(art_path)) { // Have an album artist path
-		gtk_image_set_from_file(GTK_IMAGE(self->artwork), art_path); // Update the art
-	} else {
-		gtk_image_set_from_icon_name(GTK_IMAGE(self->artwork), "audio-x-generic-symbolic"); // Use generic instead
-	}
+	koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(self->artwork), ((art_path != NULL) && g_path_is_absolute(art_path)) ? art_path : NULL, 96, 96, "audio-x-generic-symbolic"); // Update the art, or use generic instead
+
+	koto_playerbar_refresh_progress(self); // New track, so our label needs its duration
 }
 
 GtkWidget * koto_playerbar_get_main(KotoPlayerBar * self) {
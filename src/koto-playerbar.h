@@ -67,6 +67,16 @@ void koto_playerbar_handle_is_paused(
 	gpointer user_data
 );
 
+void koto_playerbar_handle_main_map(
+	GtkWidget * main,
+	gpointer user_data
+);
+
+void koto_playerbar_handle_main_unmap(
+	GtkWidget * main,
+	gpointer user_data
+);
+
 void koto_playerbar_handle_playlist_button_clicked(
 	GtkGestureClick * gesture,
 	int n_press,
@@ -105,6 +115,12 @@ void koto_playerbar_handle_progressbar_value_changed(
 	gpointer data
 );
 
+gboolean koto_playerbar_handle_progress_tick(
+	GtkWidget * progress_bar,
+	GdkFrameClock * frame_clock,
+	gpointer user_data
+);
+
 void koto_playerbar_handle_speed_input_activate(
 	GtkEntry * playback_speed_input,
 	gpointer user_data
@@ -152,6 +168,8 @@ void koto_playerbar_jump_forwards(
 	gpointer data
 );
 
+void koto_playerbar_refresh_progress(KotoPlayerBar * self);
+
 void koto_playerbar_reset_progressbar(KotoPlayerBar * self);
 
 void koto_playerbar_set_progressbar_duration(
@@ -164,6 +182,10 @@ void koto_playerbar_set_progressbar_value(
 	gdouble progress
 );
 
+void koto_playerbar_start_progress_tick(KotoPlayerBar * self);
+
+void koto_playerbar_stop_progress_tick(KotoPlayerBar * self);
+
 void koto_playerbar_toggle_play_pause(
 	GtkGestureClick * gesture,
 	int n_press,
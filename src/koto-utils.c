@@ -20,9 +20,11 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include "koto-art-cache.h"
 #include "koto-utils.h"
 
 extern GtkWindow * main_window;
+extern KotoArtCache * koto_art_cache;
 
 GtkFileChooserNative * koto_utils_create_image_file_chooser(gchar * file_chooser_label) {
 	GtkFileChooserNative * chooser = gtk_file_chooser_native_new(
@@ -48,22 +50,15 @@ GtkWidget * koto_utils_create_image_from_filepath(
 	guint width,
 	guint height
 ) {
-	GtkWidget * image = NULL;
-
-	if ((filepath != NULL) && (strcmp(filepath, "") != 0)) { // If we have a filepath
-		if (g_file_test(filepath, G_FILE_TEST_EXISTS)) { // File exists
-			image = gtk_image_new_from_file(filepath); // Load from the filepath
-		}
-	}
-
-	if (!GTK_IS_IMAGE(image)) { // If we failed to get the image or never passed a valid filepath to begin with
-		image = gtk_image_new_from_icon_name(fallback_icon); // Set to the fallback icon
-	}
+	GtkWidget * image = gtk_image_new();
+	gboolean have_file = koto_utils_string_is_valid(filepath) && g_file_test(filepath, G_FILE_TEST_EXISTS);
 
 	gtk_image_set_icon_size(GTK_IMAGE(image), GTK_ICON_SIZE_INHERIT);
 	gtk_image_set_pixel_size(GTK_IMAGE(image), width);
 	gtk_widget_set_size_request(image, width, height);
 
+	koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(image), have_file ? filepath : NULL, width, height, fallback_icon); // Shows the fallback icon until the art is decoded off the main thread
+
 	return image;
 }
 
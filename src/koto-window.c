@@ -52,6 +52,7 @@ struct _KotoWindow {
 
 	GtkWidget * overlay;
 	GtkWidget * header_bar;
+	GtkWidget * loading_spinner;
 	GtkWidget * menu_button;
 	GtkWidget * search_entry;
 
@@ -272,6 +273,24 @@ void koto_window_remove_page(
 	}
 }
 
+void koto_window_set_loading(
+	KotoWindow * self,
+	gboolean loading
+) {
+	if (!KOTO_IS_WINDOW(self)) { // Not a Koto Window
+		return;
+	}
+
+	gtk_spinner_set_spinning(GTK_SPINNER(self->loading_spinner), loading);
+	gtk_widget_set_visible(self->loading_spinner, loading); // Only show the spinner while we are loading
+
+	if (loading) { // Still loading the library
+		gtk_widget_add_css_class(self->content_layout, "loading");
+	} else {
+		gtk_widget_remove_css_class(self->content_layout, "loading");
+	}
+}
+
 void koto_window_show_dialog(
 	KotoWindow * self,
 	gchar * dialog_name
@@ -292,7 +311,12 @@ void create_new_headerbar(KotoWindow * self) {
 	gtk_widget_set_size_request(self->search_entry, 400, -1); // Have 400px width
 	g_object_set(self->search_entry, "placeholder-text", "Search...", NULL);
 
+	self->loading_spinner = gtk_spinner_new(); // Spinner to show while the library is loading
+	gtk_widget_set_tooltip_text(self->loading_spinner, "Loading library...");
+	gtk_widget_set_visible(self->loading_spinner, FALSE);
+
 	gtk_header_bar_pack_start(GTK_HEADER_BAR(self->header_bar), self->menu_button);
+	gtk_header_bar_pack_end(GTK_HEADER_BAR(self->header_bar), self->loading_spinner);
 	gtk_header_bar_set_show_title_buttons(GTK_HEADER_BAR(self->header_bar), TRUE);
 	gtk_header_bar_set_title_widget(GTK_HEADER_BAR(self->header_bar), self->search_entry);
 
@@ -58,6 +58,11 @@ void koto_window_remove_page(
 	gchar * page_name
 );
 
+void koto_window_set_loading(
+	KotoWindow * self,
+	gboolean loading
+);
+
 void koto_window_show_dialog(
 	KotoWindow * self,
 	gchar * dialog_name
@@ -31,6 +31,7 @@
 #include "playlist/current.h"
 
 #include "config/config.h"
+#include "koto-art-cache.h"
 #include "koto-paths.h"
 #include "koto-window.h"
 
@@ -39,6 +40,7 @@ extern KotoConfig * config;
 extern guint mpris_bus_id;
 extern GDBusNodeInfo * introspection_data;
 
+extern KotoArtCache * koto_art_cache;
 extern KotoPlaybackEngine * playback_engine;
 extern KotoCartographer * koto_maps;
 extern KotoCurrentPlaylist * current_playlist;
@@ -67,7 +69,9 @@ static void on_activate (GtkApplication * app) {
 		setup_mediakeys_interface(); // Set up our media key support
 
 		if (!created_new_db) {
-			read_from_db(); // Read the database, allowing us to propagate the UI with various data such as artists and playlist navigation elements
+			read_from_db(); // Start reading the database in the background, propagating the UI with various data such as artists and playlist navigation elements as it loads, then reconcile our libraries
+		} else {
+			koto_config_reconcile_libs(config); // Nothing to load, so index any libraries we already had straight away
 		}
 	}
 
@@ -77,6 +81,7 @@ static void on_activate (GtkApplication * app) {
 static void on_shutdown(GtkApplication * app) {
 	(void) app;
 	koto_current_playlist_save_playlist_state(current_playlist); // Save the current playlist state if necessary before closure
+	koto_art_cache_log_thumbnail_stats(koto_art_cache); // Report how much artwork we could load without decoding the originals
 	koto_config_save(config); // Save our config
 	close_db(); // Close the database
 	g_bus_unown_name(mpris_bus_id);
@@ -100,6 +105,7 @@ int main (
 	koto_playback_engine_get_supported_mimetypes(supported_mimes);
 
 	koto_maps = koto_cartographer_new(); // Create our new cartographer and their collection of maps
+	koto_art_cache = koto_art_cache_new(); // Create our shared artwork texture cache
 
 	volume_monitor = g_volume_monitor_get(); // Get a VolumeMonitor
 
@@ -108,6 +114,7 @@ int main (
 	playback_engine = koto_playback_engine_new(); // Initialize the engine now that the config is available, since it listens on various config signals
 
 	taglib_id3v2_set_default_text_encoding(TagLib_ID3v2_UTF8); // Ensure our id3v2 text encoding is UTF-8
+	taglib_set_string_management_enabled(FALSE); // TagLib's managed string list is global and not thread-safe, so our indexer workers free their own strings
 	magic_cookie = magic_open(MAGIC_MIME);
 
 	if (magic_cookie == NULL) { // Failed to open
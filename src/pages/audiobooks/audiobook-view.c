@@ -24,10 +24,12 @@
 #include "../../indexer/album-playlist-funcs.h"
 #include "../../indexer/structs.h"
 #include "../../playlist/current.h"
+#include "../../koto-art-cache.h"
 #include "../../koto-utils.h"
 #include "../../koto-window.h"
 #include "audiobook-view.h"
 
+extern KotoArtCache * koto_art_cache;
 extern KotoCartographer * koto_maps;
 extern KotoCurrentPlaylist * current_playlist;
 extern KotoWindow * main_window;
@@ -171,20 +173,26 @@ void koto_audiobook_view_set_album(
 		return;
 	}
 
+	if (self->album == album) { // Already showing this album
+		return;
+	}
+
+	if (KOTO_IS_ALBUM(self->album) && KOTO_IS_PLAYLIST(koto_album_get_playlist(self->album))) { // Views are recycled, so stop following the album we showed before
+		g_signal_handlers_disconnect_by_data(koto_album_get_playlist(self->album), self);
+	}
+
 	self->album = album;
 
 	gchar * album_art_path = koto_album_get_art(album); // Get any artwork
 
-	if (koto_utils_string_is_valid(album_art_path)) { // Have album art
-		gtk_image_set_from_file(GTK_IMAGE(self->audiobook_art), album_art_path); // Set our album art
-	}
+	koto_art_cache_set_image(koto_art_cache, GTK_IMAGE(self->audiobook_art), album_art_path, 220, 220, "audio-x-generic-symbolic"); // Set our album art, or do not keep the art of a previous album
 
 	koto_album_info_set_album_uuid(self->album_info, koto_album_get_uuid(album)); // Apply our album info
 
 	gtk_list_box_bind_model(
 		// Apply our binding for the GtkListBox
 		GTK_LIST_BOX(self->tracks_list),
-		G_LIST_MODEL(koto_album_get_store(album)),
+		G_LIST_MODEL(koto_album_get_playlist(album)), // Album playlists are sorted by track position
 		koto_audiobook_view_create_track_item,
 		NULL,
 		koto_audiobook_view_destroy_associated_user_data
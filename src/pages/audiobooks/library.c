@@ -17,7 +17,6 @@
 
 #include <glib-2.0/glib.h>
 #include <gtk-4.0/gtk/gtk.h>
-#include "../../components/button.h"
 #include "../../db/cartographer.h"
 #include "../../indexer/structs.h"
 #include "../../koto-utils.h"
@@ -34,12 +33,13 @@ struct _KotoAudiobooksLibraryPage {
 
 	GtkWidget * main; // Our main content, contains banner and scrolled window
 	GtkWidget * content_scroll; // Our Scrolled Window
-	GtkWidget * content; // Content inside scrolled window
 
 	KotoAudiobooksGenresBanner * banner;
 
-	GtkWidget * writers_flow;
-	GHashTable * writers_to_buttons; // HashTable of UUIDs of "Artists" to their KotoButton
+	GtkWidget * writers_grid; // GtkGridView of our writers, directly in the scrolled window so only visible items get widgets
+	GListStore * writers; // KotoArtists in our audiobook library
+	GHashTable * writer_uuids; // UUIDs of the KotoArtists in writers, so checking for one we already have does not walk the store
+	GtkSortListModel * sorted_writers;
 	GHashTable * writers_to_pages; // HashTable of UUIDs of "Artists" to their KotoAudiobooksWritersPage
 };
 
@@ -55,126 +55,179 @@ static void koto_audiobooks_library_page_init(KotoAudiobooksLibraryPage * self)
 	self->main = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
 	gtk_widget_add_css_class(self->main, "audiobook-library");
 	self->content_scroll = gtk_scrolled_window_new(); // Create our GtkScrolledWindow
-	self->content = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_widget_set_vexpand(self->content, TRUE); // Ensure content expands vertically to allow flowboxchild to take up as much space as it requests
-	gtk_widget_add_css_class(self->content, "content");
+	gtk_widget_set_vexpand(self->content_scroll, TRUE); // Ensure content expands vertically
 
 	self->banner = koto_audiobooks_genres_banner_new(); // Create our banner
 
-	self->writers_flow = gtk_flow_box_new(); // Create our flow box
-	//gtk_flow_box_set_homogeneous(GTK_FLOW_BOX(self->writers_flow), TRUE);
-	gtk_flow_box_set_max_children_per_line(GTK_FLOW_BOX(self->writers_flow), 100); // Set to a random amount that is not realistic, however GTK sets a default to 7 which is too small.
-	gtk_flow_box_set_selection_mode(GTK_FLOW_BOX(self->writers_flow), GTK_SELECTION_NONE);
-	gtk_widget_add_css_class(self->writers_flow, "writers-button-flow");
+	self->writers = g_list_store_new(KOTO_TYPE_ARTIST); // Create our writers model
+	self->writer_uuids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->sorted_writers = gtk_sort_list_model_new(G_LIST_MODEL(self->writers), GTK_SORTER(gtk_custom_sorter_new(koto_audiobooks_library_page_sort_writers, NULL, NULL)));
 
-	self->writers_to_buttons = g_hash_table_new(g_str_hash, g_str_equal);
-	self->writers_to_pages = g_hash_table_new(g_str_hash, g_str_equal);
+	GtkListItemFactory * factory = gtk_signal_list_item_factory_new(); // Item widgets are recycled as we scroll
+	g_signal_connect(factory, "setup", G_CALLBACK(koto_audiobooks_library_page_handle_writer_setup), self);
+	g_signal_connect(factory, "bind", G_CALLBACK(koto_audiobooks_library_page_handle_writer_bind), self);
 
-	g_signal_connect(koto_maps, "album-added", G_CALLBACK(koto_audiobooks_library_page_handle_add_album), self); // Notify when we have a new Album
-	g_signal_connect(koto_maps, "artist-added", G_CALLBACK(koto_audiobooks_library_page_handle_add_artist), self); // Notify when we have a new Artist
+	self->writers_grid = gtk_grid_view_new(GTK_SELECTION_MODEL(gtk_no_selection_new(G_LIST_MODEL(self->sorted_writers))), factory); // Create our grid view
+	gtk_grid_view_set_max_columns(GTK_GRID_VIEW(self->writers_grid), 100); // Set to a random amount that is not realistic, however GTK sets a default to 7 which is too small.
+	gtk_grid_view_set_single_click_activate(GTK_GRID_VIEW(self->writers_grid), TRUE);
+	gtk_widget_add_css_class(self->writers_grid, "content");
+	gtk_widget_add_css_class(self->writers_grid, "writers-button-grid");
+	g_signal_connect(self->writers_grid, "activate", G_CALLBACK(koto_audiobooks_library_page_handle_writer_activate), self);
 
-	gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(self->content_scroll), self->content); // Add our content to the content scroll
+	self->writers_to_pages = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+	g_signal_connect(koto_maps, "albums-added", G_CALLBACK(koto_audiobooks_library_page_handle_add_albums), self); // Notify when we have new Albums
+	g_signal_connect(koto_maps, "artists-added", G_CALLBACK(koto_audiobooks_library_page_handle_add_artists), self); // Notify when we have new Artists
+
+	gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(self->content_scroll), self->writers_grid); // Add our grid to the content scroll
 	gtk_box_append(GTK_BOX(self->main), koto_audiobooks_genres_banner_get_main(self->banner)); // Add the banner to the content
 	gtk_box_append(GTK_BOX(self->main), self->content_scroll); // Add our scroll window to the main content
-	gtk_box_append(GTK_BOX(self->content), self->writers_flow); // Add our flowbox to the content
 }
 
 static void koto_audiobooks_library_page_class_init(KotoAudiobooksLibraryPageClass * c) {
 	(void) c;
 }
 
-void koto_audiobooks_library_page_create_artist_ux(
-	KotoAudiobooksLibraryPage * self,
-	KotoArtist * artist
+void koto_audiobooks_library_page_handle_add_albums(
+	KotoCartographer * carto,
+	GPtrArray * albums,
+	KotoAudiobooksLibraryPage * self
 ) {
-	if (!KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self)) { // Not a AudiobooksLibraryPage
+	if (!KOTO_IS_CARTOGRAPHER(carto)) { // Not cartographer
 		return;
 	}
 
-	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
+	if (!KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self)) { // Not a AudiobooksLibraryPage
 		return;
 	}
 
-	gchar * artist_uuid = koto_artist_get_uuid(artist); // Get the artist UUID
-
-	if (!g_hash_table_contains(self->writers_to_pages, artist_uuid)) { // Don't have the page
-		KotoWriterPage * writers_page = koto_writer_page_new(artist);
-		koto_window_add_page(main_window, artist_uuid, koto_writer_page_get_main(writers_page)); // Add the page to the stack
-	}
+	for (guint i = 0; i < albums->len; i++) { // For each album added in this batch
+		KotoAlbum * album = g_ptr_array_index(albums, i);
 
-	if (!g_hash_table_contains(self->writers_to_buttons, artist_uuid)) { // Don't have the button for this
-		KotoButton * artist_button = koto_button_new_plain(koto_artist_get_name(artist)); // Create a KotoButton for this artist
-		koto_button_set_data(artist_button, artist_uuid); // Set the artist_uuid as the data for the button
+		if (!KOTO_IS_ALBUM(album)) { // Not an album
+			continue;
+		}
 
-		koto_button_set_text_justify(artist_button, GTK_JUSTIFY_CENTER); // Center the text
-		koto_button_set_text_wrap(artist_button, TRUE);
-		gtk_widget_add_css_class(GTK_WIDGET(artist_button), "writer-button");
-		gtk_widget_set_size_request(GTK_WIDGET(artist_button), 260, 120);
+		gchar * artist_uuid = koto_album_get_artist_uuid(album); // Get the Album's artist UUID
+		KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid);
 
-		koto_button_add_click_handler(artist_button, KOTO_BUTTON_CLICK_TYPE_PRIMARY, G_CALLBACK(koto_button_global_page_nav_callback), artist_button);
+		if (!KOTO_IS_ARTIST(artist)) { // Failed to get artist
+			continue;
+		}
 
-		g_hash_table_replace(self->writers_to_buttons, artist_uuid, artist_button); // Add the button to the Writers to Buttons hashtable
-		gtk_flow_box_insert(GTK_FLOW_BOX(self->writers_flow), GTK_WIDGET(artist_button), -1); // Append the button to our flowbox
+		if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_AUDIOBOOK) { // Not in an Audiobook library
+			continue;
+		}
 
-		GtkWidget * button_parent = gtk_widget_get_parent(GTK_WIDGET(artist_button)); // This is the GtkFlowboxChild that the button is in
-		gtk_widget_set_halign(button_parent, GTK_ALIGN_START);
+		koto_audiobooks_library_page_add_genres(self, koto_album_get_genres(album)); // Add all the genres necessary for this album
 	}
 }
 
-void koto_audiobooks_library_page_handle_add_album(
+void koto_audiobooks_library_page_handle_add_artists(
 	KotoCartographer * carto,
-	KotoAlbum * album,
+	GPtrArray * artists,
 	KotoAudiobooksLibraryPage * self
 ) {
-
 	if (!KOTO_IS_CARTOGRAPHER(carto)) { // Not cartographer
 		return;
 	}
 
-	if (!KOTO_IS_ALBUM(album)) { // Not an album
-		return;
-	}
-
 	if (!KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self)) { // Not a AudiobooksLibraryPage
 		return;
 	}
 
-	gchar * artist_uuid = koto_album_get_artist_uuid(album); // Get the Album's artist UUID
-	KotoArtist * artist = koto_cartographer_get_artist_by_uuid(koto_maps, artist_uuid);
+	GPtrArray * new_writers = g_ptr_array_sized_new(artists->len);
 
-	if (!KOTO_IS_ARTIST(artist)) { // Failed to get artist
-		return;
+	for (guint i = 0; i < artists->len; i++) { // For each artist added in this batch
+		KotoArtist * artist = g_ptr_array_index(artists, i);
+
+		if (!KOTO_IS_ARTIST(artist)) { // Not an artist
+			continue;
+		}
+
+		if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_AUDIOBOOK) { // Not in an Audiobook library
+			continue;
+		}
+
+		gchar * artist_uuid = koto_artist_get_uuid(artist);
+
+		if (g_hash_table_contains(self->writer_uuids, artist_uuid)) { // Already have this writer, including earlier in this batch
+			continue;
+		}
+
+		g_hash_table_add(self->writer_uuids, g_strdup(artist_uuid));
+		g_ptr_array_add(new_writers, artist);
 	}
 
-	if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_AUDIOBOOK) { // Not in an Audiobook library
-		return;
+	if (new_writers->len != 0) { // Have writers to add
+		g_list_store_splice(self->writers, g_list_model_get_n_items(G_LIST_MODEL(self->writers)), 0, new_writers->pdata, new_writers->len); // One items-changed for the whole batch
 	}
 
-	koto_audiobooks_library_page_add_genres(self, koto_album_get_genres(album)); // Add all the genres necessary for this album
+	g_ptr_array_free(new_writers, TRUE);
 }
 
-void koto_audiobooks_library_page_handle_add_artist(
-	KotoCartographer * carto,
-	KotoArtist * artist,
-	KotoAudiobooksLibraryPage * self
+void koto_audiobooks_library_page_handle_writer_activate(
+	GtkGridView * grid_view,
+	guint position,
+	gpointer user_data
 ) {
-	if (!KOTO_IS_CARTOGRAPHER(carto)) { // Not cartographer
+	(void) grid_view;
+	KotoAudiobooksLibraryPage * self = user_data;
+
+	if (!KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self)) { // Not a AudiobooksLibraryPage
 		return;
 	}
 
+	KotoArtist * artist = g_list_model_get_item(G_LIST_MODEL(self->sorted_writers), position);
+
 	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
 		return;
 	}
 
-	if (!KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self)) { // Not a AudiobooksLibraryPage
-		return;
+	gchar * artist_uuid = koto_artist_get_uuid(artist); // Get the artist UUID
+
+	if (!g_hash_table_contains(self->writers_to_pages, artist_uuid)) { // Don't have the page yet, so create it on first visit
+		KotoWriterPage * writers_page = koto_writer_page_new(artist);
+		koto_window_add_page(main_window, artist_uuid, koto_writer_page_get_main(writers_page)); // Add the page to the stack
+		g_hash_table_replace(self->writers_to_pages, g_strdup(artist_uuid), writers_page);
 	}
 
-	if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_AUDIOBOOK) { // Not in an Audiobook library
+	koto_window_go_to_page(main_window, artist_uuid);
+	g_object_unref(artist); // Drop the reference from g_list_model_get_item
+}
+
+void koto_audiobooks_library_page_handle_writer_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+) {
+	(void) factory;
+	(void) user_data;
+	KotoArtist * artist = gtk_list_item_get_item(item);
+
+	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
 		return;
 	}
 
-	koto_audiobooks_library_page_create_artist_ux(self, artist); // Create the UX for the artist if necessary
+	gchar * artist_name = koto_artist_get_name(artist);
+	gtk_label_set_text(GTK_LABEL(gtk_list_item_get_child(item)), artist_name);
+	g_free(artist_name);
+}
+
+void koto_audiobooks_library_page_handle_writer_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+) {
+	(void) factory;
+	(void) user_data;
+	GtkWidget * writer_label = gtk_label_new(NULL);
+
+	gtk_label_set_justify(GTK_LABEL(writer_label), GTK_JUSTIFY_CENTER); // Center the text
+	gtk_label_set_wrap(GTK_LABEL(writer_label), TRUE);
+	gtk_widget_add_css_class(writer_label, "writer-button");
+	gtk_widget_set_size_request(writer_label, 260, 120);
+	gtk_list_item_set_child(item, writer_label);
 }
 
 void koto_audiobooks_library_page_add_genres(
@@ -204,6 +257,17 @@ void koto_audiobooks_library_page_add_genres(
 	}
 }
 
+int koto_audiobooks_library_page_sort_writers(
+	gconstpointer writer1,
+	gconstpointer writer2,
+	gpointer user_data
+) {
+	(void) user_data;
+	gint ret = g_strcmp0(koto_artist_get_name_collation_key((KotoArtist*) writer1), koto_artist_get_name_collation_key((KotoArtist*) writer2));
+
+	return (ret < 0) ? GTK_ORDERING_SMALLER : ((ret > 0) ? GTK_ORDERING_LARGER : GTK_ORDERING_EQUAL);
+}
+
 GtkWidget * koto_audiobooks_library_page_get_main(KotoAudiobooksLibraryPage * self) {
 	return KOTO_IS_AUDIOBOOKS_LIBRARY_PAGE(self) ? self->main : NULL;
 }
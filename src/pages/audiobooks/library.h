@@ -39,18 +39,42 @@ void koto_audiobooks_library_page_add_genres(
 	GList * genres
 );
 
-void koto_audiobooks_library_page_handle_add_album(
+void koto_audiobooks_library_page_handle_add_albums(
 	KotoCartographer * carto,
-	KotoAlbum * album,
+	GPtrArray * albums,
 	KotoAudiobooksLibraryPage * self
 );
 
-void koto_audiobooks_library_page_handle_add_artist(
+void koto_audiobooks_library_page_handle_add_artists(
 	KotoCartographer * carto,
-	KotoArtist * artist,
+	GPtrArray * artists,
 	KotoAudiobooksLibraryPage * self
 );
 
+void koto_audiobooks_library_page_handle_writer_activate(
+	GtkGridView * grid_view,
+	guint position,
+	gpointer user_data
+);
+
+void koto_audiobooks_library_page_handle_writer_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+);
+
+void koto_audiobooks_library_page_handle_writer_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+);
+
+int koto_audiobooks_library_page_sort_writers(
+	gconstpointer writer1,
+	gconstpointer writer2,
+	gpointer user_data
+);
+
 GtkWidget * koto_audiobooks_library_page_get_main(KotoAudiobooksLibraryPage * self);
 
 KotoAudiobooksLibraryPage * koto_audiobooks_library_page_new();
\ No newline at end of file
@@ -42,13 +42,13 @@ struct _KotoWriterPage {
 
 	KotoArtist * artist;
 
-	GtkWidget * main; // Our main content will be a scrolled Scrolled Window
-	GtkWidget * content; // Content inside scrolled window
+	GtkWidget * main; // Our main content, contains our header and scrolled window
+	GtkWidget * content_scroll; // Scrolled window directly holding our grid so only visible audiobooks get views
 
 	GtkWidget * writers_header; // Header GtkLabel for the writer
 	GListModel * model;
 
-	GtkWidget * audiobooks_flow;
+	GtkWidget * audiobooks_grid;
 };
 
 struct _KotoWriterPageClass {
@@ -90,27 +90,30 @@ static void koto_writer_page_class_init(KotoWriterPageClass * c) {
 }
 
 static void koto_writer_page_init(KotoWriterPage * self) {
-	self->main = gtk_scrolled_window_new(); // Set main to be a scrolled window
-	self->content = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	gtk_widget_add_css_class(self->content, "writer-page");
-
-	gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(self->main), self->content); // Set content to be the child of the scrolled window
+	self->main = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	gtk_widget_add_css_class(self->main, "writer-page");
 
 	self->writers_header = gtk_label_new(NULL); // Create an empty label
 	gtk_widget_add_css_class(self->writers_header, "writer-header");
 	gtk_widget_set_halign(self->writers_header, GTK_ALIGN_START);
 
-	self->audiobooks_flow = gtk_flow_box_new(); // Create our flowbox of the audiobooks views
-	gtk_widget_add_css_class(self->audiobooks_flow, "audiobooks-flow");
+	self->content_scroll = gtk_scrolled_window_new();
+	gtk_widget_set_vexpand(self->content_scroll, TRUE); // Expand vertically
+
+	GtkListItemFactory * factory = gtk_signal_list_item_factory_new(); // Audiobook views are recycled as we scroll
+	g_signal_connect(factory, "setup", G_CALLBACK(koto_writer_page_handle_item_setup), self);
+	g_signal_connect(factory, "bind", G_CALLBACK(koto_writer_page_handle_item_bind), self);
 
-	gtk_flow_box_set_max_children_per_line(GTK_FLOW_BOX(self->audiobooks_flow), 2); // Allow 2 to ensure adequate spacing for description
-	gtk_flow_box_set_selection_mode(GTK_FLOW_BOX(self->audiobooks_flow), GTK_SELECTION_NONE); // Do not allow selection
+	self->audiobooks_grid = gtk_grid_view_new(NULL, factory); // Create our grid of the audiobooks views, model is set with our artist
+	gtk_widget_add_css_class(self->audiobooks_grid, "audiobooks-grid");
+	gtk_grid_view_set_max_columns(GTK_GRID_VIEW(self->audiobooks_grid), 2); // Allow 2 to ensure adequate spacing for description
 
-	gtk_widget_set_hexpand(self->audiobooks_flow, TRUE); // Expand horizontally
-	gtk_widget_set_vexpand(self->audiobooks_flow, TRUE); // Expand vertically
+	gtk_widget_set_hexpand(self->audiobooks_grid, TRUE); // Expand horizontally
+	gtk_widget_set_vexpand(self->audiobooks_grid, TRUE); // Expand vertically
 
-	gtk_box_append(GTK_BOX(self->content), self->writers_header);
-	gtk_box_append(GTK_BOX(self->content), self->audiobooks_flow); // Add the audiobooks flow to the content
+	gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(self->content_scroll), self->audiobooks_grid);
+	gtk_box_append(GTK_BOX(self->main), self->writers_header);
+	gtk_box_append(GTK_BOX(self->main), self->content_scroll); // Add the audiobooks grid to the main content
 }
 
 static void koto_writer_page_get_property(
@@ -149,21 +152,33 @@ static void koto_writer_page_set_property(
 	}
 }
 
-GtkWidget * koto_writer_page_create_item(
-	gpointer item,
+void koto_writer_page_handle_item_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
 	gpointer user_data
 ) {
+	(void) factory;
 	(void) user_data;
 
-	KotoAlbum * album = KOTO_ALBUM(item); // Cast the model data as an album
+	KotoAlbum * album = gtk_list_item_get_item(item);
 
 	if (!KOTO_IS_ALBUM(album)) { // Fetched item from list is not album
-		return NULL;
+		return;
 	}
 
-	KotoAudiobookView * view = koto_audiobook_view_new(); // Create our KotoAudiobookView
-	koto_audiobook_view_set_album(view, album); // Set the item for this set up audiobook view
-	return GTK_WIDGET(view);
+	koto_audiobook_view_set_album(KOTO_AUDIOBOOK_VIEW(gtk_list_item_get_child(item)), album); // Point our recycled audiobook view at this album
+}
+
+void koto_writer_page_handle_item_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+) {
+	(void) factory;
+	(void) user_data;
+
+	gtk_list_item_set_activatable(item, FALSE); // Views have their own playback button
+	gtk_list_item_set_child(item, GTK_WIDGET(koto_audiobook_view_new())); // Create our KotoAudiobookView
 }
 
 GtkWidget * koto_writer_page_get_main(KotoWriterPage * self) {
@@ -187,13 +202,9 @@ void koto_writer_page_set_artist(
 
 	self->model = G_LIST_MODEL(koto_artist_get_albums_store(artist)); // Get the store and cast it as a list model for our model
 
-	gtk_flow_box_bind_model(
-		GTK_FLOW_BOX(self->audiobooks_flow),
-		self->model,
-		koto_writer_page_create_item,
-		NULL,
-		NULL
-	);
+	GtkSelectionModel * selection_model = GTK_SELECTION_MODEL(gtk_no_selection_new(g_object_ref(self->model))); // No selection model takes ownership of our ref, the store stays with the artist
+	gtk_grid_view_set_model(GTK_GRID_VIEW(self->audiobooks_grid), selection_model);
+	g_object_unref(selection_model); // Grid view keeps its own reference
 }
 
 KotoWriterPage * koto_writer_page_new(KotoArtist * artist) {
@@ -24,8 +24,15 @@ G_BEGIN_DECLS
 #define KOTO_TYPE_WRITER_PAGE (koto_writer_page_get_type())
 G_DECLARE_FINAL_TYPE(KotoWriterPage, koto_writer_page, KOTO, WRITER_PAGE, GObject)
 
-GtkWidget* koto_writer_page_create_item(
-	gpointer item,
+void koto_writer_page_handle_item_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+);
+
+void koto_writer_page_handle_item_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
 	gpointer user_data
 );
 
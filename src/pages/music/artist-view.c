@@ -298,6 +298,16 @@ void koto_artist_view_set_artist(
 	g_signal_connect(artist, "album-removed", G_CALLBACK(koto_artist_view_handle_album_removed), self);
 	g_signal_connect(artist, "has-no-albums", G_CALLBACK(koto_artist_view_handle_has_no_albums), self);
 	g_signal_connect(artist, "notify::name", G_CALLBACK(koto_artist_view_handle_artist_name_changed), self);
+
+	GQueue * albums = koto_artist_get_albums(self->artist); // Views can be created well after indexing, so pick up the albums we already have
+
+	if (albums == NULL) {
+		return;
+	}
+
+	for (GList * cur_album = albums->head; cur_album != NULL; cur_album = cur_album->next) { // For each existing album
+		koto_artist_view_add_album(self, cur_album->data);
+	}
 }
 
 void koto_artist_view_toggle_playback(
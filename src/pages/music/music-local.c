@@ -31,7 +31,10 @@ struct _KotoPageMusicLocal {
 	GtkWidget * scrolled_window;
 	GtkWidget * artist_list;
 	GtkWidget * stack;
-	GHashTable * artist_name_to_buttons;
+
+	GListStore * artists; // KotoArtists in our music library
+	GtkSortListModel * sorted_artists;
+	GHashTable * artist_names_to_artists; // Artist name to KotoArtist, so we can create artist pages when they are first visited
 
 	gboolean constructed;
 };
@@ -55,7 +58,7 @@ static void koto_page_music_local_class_init(KotoPageMusicLocalClass * c) {
 
 static void koto_page_music_local_init(KotoPageMusicLocal * self) {
 	self->constructed = FALSE;
-	self->artist_name_to_buttons = g_hash_table_new(g_str_hash, g_str_equal);
+	self->artist_names_to_artists = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 
 	gtk_widget_add_css_class(GTK_WIDGET(self), "page-music-local");
 	gtk_widget_set_hexpand(GTK_WIDGET(self), TRUE);
@@ -68,11 +71,19 @@ static void koto_page_music_local_init(KotoPageMusicLocal * self) {
 	gtk_widget_set_vexpand(self->scrolled_window, TRUE); // Expand our scrolled window
 	gtk_box_prepend(GTK_BOX(self), self->scrolled_window);
 
-	self->artist_list = gtk_list_box_new(); // Create our artist list
-	g_signal_connect(GTK_LIST_BOX(self->artist_list), "row-activated", G_CALLBACK(koto_page_music_local_handle_artist_click), self);
-	gtk_list_box_set_activate_on_single_click(GTK_LIST_BOX(self->artist_list), TRUE);
-	gtk_list_box_set_selection_mode(GTK_LIST_BOX(self->artist_list), GTK_SELECTION_BROWSE);
-	gtk_list_box_set_sort_func(GTK_LIST_BOX(self->artist_list), koto_page_music_local_sort_artists, NULL, NULL); // Add our sort function
+	self->artists = g_list_store_new(KOTO_TYPE_ARTIST); // Create our artist model
+	self->sorted_artists = gtk_sort_list_model_new(G_LIST_MODEL(self->artists), GTK_SORTER(gtk_custom_sorter_new(koto_page_music_local_sort_artists, NULL, NULL))); // Sort on collation keys, once per batch rather than once per artist
+
+	GtkSingleSelection * selection_model = gtk_single_selection_new(G_LIST_MODEL(self->sorted_artists));
+	gtk_single_selection_set_autoselect(selection_model, FALSE); // Do not select (and so navigate to) the first artist on our own
+
+	GtkListItemFactory * factory = gtk_signal_list_item_factory_new(); // Only the visible rows get widgets, which are recycled as we scroll
+	g_signal_connect(factory, "setup", G_CALLBACK(koto_page_music_local_handle_artist_row_setup), self);
+	g_signal_connect(factory, "bind", G_CALLBACK(koto_page_music_local_handle_artist_row_bind), self);
+
+	self->artist_list = gtk_list_view_new(GTK_SELECTION_MODEL(selection_model), factory); // Create our artist list
+	gtk_list_view_set_single_click_activate(GTK_LIST_VIEW(self->artist_list), TRUE);
+	g_signal_connect(self->artist_list, "activate", G_CALLBACK(koto_page_music_local_handle_artist_click), self);
 	gtk_scrolled_window_set_child(GTK_SCROLLED_WINDOW(self->scrolled_window), self->artist_list);
 
 	self->stack = gtk_stack_new(); // Create a new stack
@@ -82,8 +93,8 @@ static void koto_page_music_local_init(KotoPageMusicLocal * self) {
 	gtk_widget_set_vexpand(self->stack, TRUE);
 	gtk_box_append(GTK_BOX(self), self->stack);
 
-	g_signal_connect(koto_maps, "artist-added", G_CALLBACK(koto_page_music_local_handle_artist_added), self);
-	g_signal_connect(koto_maps, "artist-removed", G_CALLBACK(koto_page_music_local_handle_artist_removed), self);
+	g_signal_connect(koto_maps, "artists-added", G_CALLBACK(koto_page_music_local_handle_artists_added), self); // Batched, so a large scan does not rebuild our list for every artist
+	g_signal_connect(koto_maps, "artists-removed", G_CALLBACK(koto_page_music_local_handle_artists_removed), self);
 }
 
 static void koto_page_music_local_constructed(GObject * obj) {
@@ -107,31 +118,30 @@ void koto_page_music_local_add_artist(
 
 	gchar * artist_name = koto_artist_get_name(artist); // Get the artist name
 
-	if (!GTK_IS_STACK(self->stack)) {
-		return;
-	}
-
-	GtkWidget * stack_child = gtk_stack_get_child_by_name(GTK_STACK(self->stack), artist_name);
-
-	if (GTK_IS_WIDGET(stack_child)) { // Already have a page for this artist
+	if (g_hash_table_contains(self->artist_names_to_artists, artist_name)) { // Already have this artist
 		g_free(artist_name);
 		return;
 	}
 
-	KotoButton * artist_button = koto_button_new_plain(artist_name);
-	gtk_list_box_prepend(GTK_LIST_BOX(self->artist_list), GTK_WIDGET(artist_button));
-	g_hash_table_replace(self->artist_name_to_buttons, artist_name, artist_button); // Add the KotoButton for this artist to the hash table, that way we can reference and remove it when we remove the artist
-
-	KotoArtistView * artist_view = koto_artist_view_new(artist); // Create our new artist view
-
-	gtk_stack_add_named(GTK_STACK(self->stack), koto_artist_view_get_main(artist_view), artist_name);
-	g_free(artist_name);
+	g_hash_table_replace(self->artist_names_to_artists, artist_name, artist); // Takes ownership of our name
+	g_list_store_append(self->artists, artist);
 }
 
 void koto_page_music_local_go_to_artist_by_name(
 	KotoPageMusicLocal * self,
 	gchar * artist_name
 ) {
+	if (!GTK_IS_WIDGET(gtk_stack_get_child_by_name(GTK_STACK(self->stack), artist_name))) { // Have not visited this artist yet
+		KotoArtist * artist = g_hash_table_lookup(self->artist_names_to_artists, artist_name);
+
+		if (!KOTO_IS_ARTIST(artist)) { // Not an artist we know of
+			return;
+		}
+
+		KotoArtistView * artist_view = koto_artist_view_new(artist); // Create our new artist view
+		gtk_stack_add_named(GTK_STACK(self->stack), koto_artist_view_get_main(artist_view), artist_name);
+	}
+
 	gtk_stack_set_visible_child_name(GTK_STACK(self->stack), artist_name);
 }
 
@@ -159,26 +169,63 @@ void koto_page_music_local_go_to_artist_by_uuid(
 	}
 
 	koto_page_music_local_go_to_artist_by_name(self, artist_name);
+	g_free(artist_name);
 }
 
 void koto_page_music_local_handle_artist_click(
-	GtkListBox * box,
-	GtkListBoxRow * row,
+	GtkListView * list_view,
+	guint position,
 	gpointer data
 ) {
-	(void) box;
+	(void) list_view;
 	KotoPageMusicLocal * self = (KotoPageMusicLocal*) data;
-	KotoButton * btn = KOTO_BUTTON(gtk_list_box_row_get_child(row));
+	KotoArtist * artist = g_list_model_get_item(G_LIST_MODEL(self->sorted_artists), position);
 
-	gchar * artist_name;
+	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
+		return;
+	}
 
-	g_object_get(btn, "button-text", &artist_name, NULL);
+	gchar * artist_name = koto_artist_get_name(artist);
 	koto_page_music_local_go_to_artist_by_name(self, artist_name);
+	g_free(artist_name);
+	g_object_unref(artist); // Drop the reference from g_list_model_get_item
 }
 
-void koto_page_music_local_handle_artist_added(
+void koto_page_music_local_handle_artist_row_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+) {
+	(void) factory;
+	(void) user_data;
+	KotoArtist * artist = gtk_list_item_get_item(item);
+
+	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
+		return;
+	}
+
+	gchar * artist_name = koto_artist_get_name(artist);
+	gtk_label_set_text(GTK_LABEL(gtk_list_item_get_child(item)), artist_name);
+	g_free(artist_name);
+}
+
+void koto_page_music_local_handle_artist_row_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+) {
+	(void) factory;
+	(void) user_data;
+	GtkWidget * label = gtk_label_new(NULL);
+
+	gtk_label_set_xalign(GTK_LABEL(label), 0);
+	gtk_label_set_ellipsize(GTK_LABEL(label), PANGO_ELLIPSIZE_END);
+	gtk_list_item_set_child(item, label);
+}
+
+void koto_page_music_local_handle_artists_added(
 	KotoCartographer * carto,
-	KotoArtist * artist,
+	GPtrArray * artists,
 	gpointer user_data
 ) {
 	(void) carto;
@@ -188,58 +235,76 @@ void koto_page_music_local_handle_artist_added(
 		return;
 	}
 
-	if (!KOTO_IS_ARTIST(artist)) { // Not an artist
-		return;
+	GPtrArray * new_artists = g_ptr_array_sized_new(artists->len);
+
+	for (guint i = 0; i < artists->len; i++) { // For each artist added in this batch
+		KotoArtist * artist = g_ptr_array_index(artists, i);
+
+		if (!KOTO_IS_ARTIST(artist)) { // Not an artist
+			continue;
+		}
+
+		if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_MUSIC) { // Not in our music library
+			continue;
+		}
+
+		gchar * artist_name = koto_artist_get_name(artist);
+
+		if (g_hash_table_contains(self->artist_names_to_artists, artist_name)) { // Already have this artist
+			g_free(artist_name);
+			continue;
+		}
+
+		g_hash_table_replace(self->artist_names_to_artists, artist_name, artist);
+		g_ptr_array_add(new_artists, artist);
 	}
 
-	if (koto_artist_get_lib_type(artist) != KOTO_LIBRARY_TYPE_MUSIC) { // Not in our music library
-		return;
+	if (new_artists->len != 0) { // Have artists to add
+		g_list_store_splice(self->artists, g_list_model_get_n_items(G_LIST_MODEL(self->artists)), 0, new_artists->pdata, new_artists->len); // One items-changed for the whole batch
 	}
 
-	koto_page_music_local_add_artist(self, artist); // Add the artist if needed
+	g_ptr_array_free(new_artists, TRUE);
 }
 
-void koto_page_music_local_handle_artist_removed(
+void koto_page_music_local_handle_artists_removed(
 	KotoCartographer * carto,
-	gchar * artist_uuid,
-	gchar * artist_name,
+	GPtrArray * artists,
 	gpointer user_data
 ) {
 	(void) carto;
-	(void) artist_uuid;
 
 	KotoPageMusicLocal * self = user_data;
 
-	GtkWidget * existing_artist_page = gtk_stack_get_child_by_name(GTK_STACK(self->stack), artist_name);
+	for (guint i = 0; i < artists->len; i++) { // For each artist removed in this batch
+		KotoArtist * artist = g_ptr_array_index(artists, i);
+		gchar * artist_name = koto_artist_get_name(artist);
+		GtkWidget * existing_artist_page = gtk_stack_get_child_by_name(GTK_STACK(self->stack), artist_name);
 
-	// TODO: Navigate away from artist if we are currently looking at it
-	if (GTK_IS_WIDGET(existing_artist_page)) { // Page exists
-		gtk_stack_remove(GTK_STACK(self->stack), existing_artist_page); // Remove the artist page
-	}
+		// TODO: Navigate away from artist if we are currently looking at it
+		if (GTK_IS_WIDGET(existing_artist_page)) { // Page exists
+			gtk_stack_remove(GTK_STACK(self->stack), existing_artist_page); // Remove the artist page
+		}
+
+		guint position = 0;
 
-	KotoButton * btn = g_hash_table_lookup(self->artist_name_to_buttons, artist_name);
+		if (g_list_store_find(self->artists, artist, &position)) { // If we have this artist in our list
+			g_list_store_remove(self->artists, position); // Remove the artist
+		}
 
-	if (KOTO_IS_BUTTON(btn)) { // If we have a button for this artist
-		gtk_list_box_remove(GTK_LIST_BOX(self->artist_list), GTK_WIDGET(btn)); // Remove the button
+		g_hash_table_remove(self->artist_names_to_artists, artist_name);
+		g_free(artist_name);
 	}
 }
 
 int koto_page_music_local_sort_artists(
-	GtkListBoxRow * artist1,
-	GtkListBoxRow * artist2,
+	gconstpointer artist1,
+	gconstpointer artist2,
 	gpointer user_data
 ) {
 	(void) user_data;
-	KotoButton * artist1_btn = KOTO_BUTTON(gtk_list_box_row_get_child(artist1));
-	KotoButton * artist2_btn = KOTO_BUTTON(gtk_list_box_row_get_child(artist2));
-
-	gchar * artist1_text;
-	gchar * artist2_text;
-
-	g_object_get(artist1_btn, "button-text", &artist1_text, NULL);
-	g_object_get(artist2_btn, "button-text", &artist2_text, NULL);
+	gint ret = g_strcmp0(koto_artist_get_name_collation_key((KotoArtist*) artist1), koto_artist_get_name_collation_key((KotoArtist*) artist2)); // Keys are built once when the name is set
 
-	return g_utf8_collate(artist1_text, artist2_text);
+	return (ret < 0) ? GTK_ORDERING_SMALLER : ((ret > 0) ? GTK_ORDERING_LARGER : GTK_ORDERING_EQUAL);
 }
 
 KotoPageMusicLocal * koto_page_music_local_new() {
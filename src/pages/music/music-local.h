@@ -35,21 +35,32 @@ void koto_page_music_local_add_artist(
 );
 
 void koto_page_music_local_handle_artist_click(
-	GtkListBox * box,
-	GtkListBoxRow * row,
+	GtkListView * list_view,
+	guint position,
 	gpointer data
 );
 
-void koto_page_music_local_handle_artist_added(
+void koto_page_music_local_handle_artist_row_bind(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+);
+
+void koto_page_music_local_handle_artist_row_setup(
+	GtkSignalListItemFactory * factory,
+	GtkListItem * item,
+	gpointer user_data
+);
+
+void koto_page_music_local_handle_artists_added(
 	KotoCartographer * carto,
-	KotoArtist * artist,
+	GPtrArray * artists,
 	gpointer user_data
 );
 
-void koto_page_music_local_handle_artist_removed(
+void koto_page_music_local_handle_artists_removed(
 	KotoCartographer * carto,
-	gchar * artist_uuid,
-	gchar * artist_name,
+	GPtrArray * artists,
 	gpointer user_data
 );
 
@@ -64,8 +75,8 @@ void koto_page_music_local_go_to_artist_by_uuid(
 );
 
 int koto_page_music_local_sort_artists(
-	GtkListBoxRow * artist1,
-	GtkListBoxRow * artist2,
+	gconstpointer artist1,
+	gconstpointer artist2,
 	gpointer user_data
 );
 
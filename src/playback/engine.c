@@ -28,6 +28,8 @@
 #include "engine.h"
 #include "mpris.h"
 
+#define KOTO_PLAYBACK_ENGINE_PERSIST_INTERVAL 10 // Seconds between saving our playback position
+
 enum {
 	SIGNAL_IS_PLAYING,
 	SIGNAL_IS_PAUSED,
@@ -71,8 +73,6 @@ struct _KotoPlaybackEngine {
 	gboolean is_playing_specific_track;
 	gboolean is_shuffle_enabled;
 
-	gboolean tick_duration_timer_running;
-	gboolean tick_track_timer_running;
 	gboolean tick_update_playlist_state;
 
 	gboolean via_config_continue_on_playlist; // Pulls from our Koto Config
@@ -81,6 +81,11 @@ struct _KotoPlaybackEngine {
 	guint playback_position;
 	gint requested_playback_position;
 
+	GMutex next_lock; // Guards our next track, since playbin asks for it from its streaming thread
+	gchar * next_uuid; // Track to queue once the current one is about to finish, NULL to let playback end
+	gchar * next_uri;
+	gchar * queued_uuid; // Track playbin has actually been given, kept apart from our candidate since that changes with repeat, shuffle and playlist
+
 	gdouble rate;
 	gdouble volume;
 };
@@ -100,6 +105,15 @@ struct _KotoPlaybackEngineClass {
 
 G_DEFINE_TYPE(KotoPlaybackEngine, koto_playback_engine, G_TYPE_OBJECT);
 
+static void koto_playback_engine_announce_track(KotoPlaybackEngine * self);
+
+static void koto_playback_engine_handle_about_to_finish(
+	GstElement * playbin,
+	gpointer user_data
+);
+
+static void koto_playback_engine_prepare_next_track(KotoPlaybackEngine * self);
+
 static void koto_playback_engine_class_init(KotoPlaybackEngineClass * c) {
 	c->play_state_changed = NULL;
 	GObjectClass * gobject_class;
@@ -211,6 +225,7 @@ static void koto_playback_engine_init(KotoPlaybackEngine * self) {
 	self->suppress_video = gst_element_factory_make("fakesink", "suppress-video");
 
 	g_object_set(self->playbin, "video-sink", self->suppress_video, NULL);
+	g_signal_connect(self->playbin, "about-to-finish", G_CALLBACK(koto_playback_engine_handle_about_to_finish), self); // Queue our next track before this one ends
 	self->rate = 1.0;
 	self->volume = 0.5;
 	koto_playback_engine_set_volume(self, 0.5);
@@ -232,8 +247,10 @@ static void koto_playback_engine_init(KotoPlaybackEngine * self) {
 	self->is_repeat_enabled = FALSE;
 	self->is_shuffle_enabled = FALSE;
 	self->requested_playback_position = -1;
-	self->tick_duration_timer_running = FALSE;
-	self->tick_track_timer_running = FALSE;
+	g_mutex_init(&self->next_lock);
+	self->next_uuid = NULL;
+	self->next_uri = NULL;
+	self->queued_uuid = NULL;
 	self->tick_update_playlist_state = FALSE;
 	self->via_config_continue_on_playlist = FALSE;
 	self->via_config_maintain_shuffle = TRUE;
@@ -303,6 +320,78 @@ void koto_playback_engine_backwards(KotoPlaybackEngine * self) {
 	koto_playback_engine_set_track_by_uuid(self, koto_playlist_go_to_previous(playlist), FALSE);
 }
 
+static void koto_playback_engine_handle_about_to_finish(
+	GstElement * playbin,
+	gpointer user_data
+) {
+	KotoPlaybackEngine * self = user_data; // Called from a streaming thread, so only touch what our lock guards
+
+	g_mutex_lock(&self->next_lock);
+
+	if (self->next_uri != NULL) { // Have a next track prepared
+		g_object_set(playbin, "uri", self->next_uri, NULL); // Setting this now lets playbin start decoding it before the current track ends
+		g_free(self->queued_uuid);
+		self->queued_uuid = g_strdup(self->next_uuid);
+	}
+
+	g_mutex_unlock(&self->next_lock);
+}
+
+static void koto_playback_engine_handle_gapless_transition(
+	KotoPlaybackEngine * self,
+	const gchar * track_uuid
+) {
+	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, track_uuid);
+
+	if (!KOTO_IS_TRACK(track)) { // Track went away while it was queued
+		return;
+	}
+
+	koto_playback_engine_set_track_playback_position(self, 0); // Finished the previous track, so reset its position
+
+	KotoPlaylist * playlist = koto_current_playlist_get_playlist(current_playlist);
+
+	if (KOTO_IS_PLAYLIST(playlist)) { // Keep our playlist in step with what is playing, same as koto_playback_engine_forwards
+		koto_playlist_go_to_next(playlist);
+		koto_playlist_set_track_as_current(playlist, (gchar*) track_uuid); // In case the playlist changed since we queued
+	}
+
+	self->current_track = track;
+	self->is_playing_specific_track = FALSE; // Continuing on the playlist like koto_playback_engine_forwards does
+	self->requested_playback_position = -1;
+	koto_playback_engine_announce_track(self);
+}
+
+static void koto_playback_engine_prepare_next_track(KotoPlaybackEngine * self) {
+	KotoPlaylist * playlist = koto_current_playlist_get_playlist(current_playlist);
+	gchar * next_uuid = NULL;
+
+	if (!KOTO_IS_TRACK(self->current_track) || self->is_repeat_enabled) { // Nothing playing, or repeating which already seeks back to the start on end of stream
+		next_uuid = NULL;
+	} else if (KOTO_IS_PLAYLIST(playlist) && (!self->is_playing_specific_track || self->via_config_continue_on_playlist)) { // Same rules as koto_playback_engine_forwards
+		next_uuid = koto_playlist_get_next_track_uuid(playlist);
+	}
+
+	KotoTrack * next_track = koto_utils_string_is_valid(next_uuid) ? koto_cartographer_get_track_by_uuid(koto_maps, next_uuid) : NULL;
+	gchar * next_uri = NULL;
+
+	if (KOTO_IS_TRACK(next_track) && (koto_track_get_playback_position(next_track) == 0)) { // Resuming partway through a track needs a seek, so leave that to the end of stream path
+		gchar * next_path = koto_track_get_path(next_track);
+
+		if (next_path != NULL) { // Have a file to play
+			next_uri = gst_filename_to_uri(next_path, NULL);
+			g_free(next_path);
+		}
+	}
+
+	g_mutex_lock(&self->next_lock);
+	g_free(self->next_uuid);
+	g_free(self->next_uri);
+	self->next_uuid = (next_uri != NULL) ? g_strdup(next_uuid) : NULL;
+	self->next_uri = next_uri;
+	g_mutex_unlock(&self->next_lock);
+}
+
 void koto_playback_engine_handle_current_playlist_changed(
 	KotoCurrentPlaylist * current_pl,
 	KotoPlaylist * playlist,
@@ -337,6 +426,8 @@ void koto_playback_engine_handle_current_playlist_changed(
 		}
 
 		koto_playback_engine_set_track_by_uuid(self, play_uuid, FALSE); // Go to "next" which is the first track
+	} else {
+		koto_playback_engine_prepare_next_track(self); // Our candidate next track came from the previous playlist
 	}
 }
 
@@ -505,6 +596,10 @@ gboolean koto_playback_engine_monitor_changed(
 			koto_playback_engine_tick_track(self);
 			break;
 		}
+		case GST_MESSAGE_ASYNC_DONE: { // Finished a state change or seek
+			koto_playback_engine_tick_track(self); // Position may have jumped, so let listeners catch up once
+			break;
+		}
 		case GST_MESSAGE_STATE_CHANGED: { // State changed
 			GstState old_state;
 			GstState new_state;
@@ -524,6 +619,7 @@ gboolean koto_playback_engine_monitor_changed(
 				koto_playback_engine_tick_duration(self);
 				g_signal_emit(self, playback_engine_signals[SIGNAL_IS_PLAYING], 0); // Emit our is playing state signal
 			} else if (new_state == GST_STATE_PAUSED) { // Now paused
+				koto_playback_engine_tick_track(self); // Settle on where we paused
 				g_signal_emit(self, playback_engine_signals[SIGNAL_IS_PAUSED], 0); // Emit our is paused state signal
 			}
 
@@ -533,6 +629,18 @@ gboolean koto_playback_engine_monitor_changed(
 
 			break;
 		}
+		case GST_MESSAGE_STREAM_START: { // Started a new stream, which without a flush means playbin moved on to the track we queued
+			g_mutex_lock(&self->next_lock);
+			gchar * queued_uuid = g_steal_pointer(&self->queued_uuid); // Take what playbin is now playing, whatever our candidate has become since
+			g_mutex_unlock(&self->next_lock);
+
+			if (queued_uuid != NULL) { // Moved on without a gap
+				koto_playback_engine_handle_gapless_transition(self, queued_uuid);
+				g_free(queued_uuid);
+			}
+
+			break;
+		}
 		case GST_MESSAGE_EOS: { // Reached end of stream
 			koto_playback_engine_forwards(self); // Go to the next track
 			break;
@@ -551,19 +659,9 @@ void koto_playback_engine_play(KotoPlaybackEngine * self) {
 	self->is_playing = TRUE;
 	gst_element_set_state(self->player, GST_STATE_PLAYING); // Set our state to play
 
-	if (!self->tick_duration_timer_running) {
-		self->tick_duration_timer_running = TRUE;
-		g_timeout_add(1000, koto_playback_engine_tick_duration, self); // Create a 1s duration tick
-	}
-
-	if (!self->tick_track_timer_running) {
-		self->tick_track_timer_running = TRUE;
-		g_timeout_add(100, koto_playback_engine_tick_track, self); // Create a 100ms track tick
-	}
-
 	if (!self->tick_update_playlist_state) {
 		self->tick_update_playlist_state = TRUE;
-		g_timeout_add(60000, koto_playback_engine_tick_update_playlist_state, self); // Update the current playlist state every minute
+		g_timeout_add_seconds(KOTO_PLAYBACK_ENGINE_PERSIST_INTERVAL, koto_playback_engine_tick_update_playlist_state, self); // Persist our position on a slow, coalesced timer. Anything drawing progress asks for it from its own frame clock
 	}
 
 	koto_update_mpris_playback_state(GST_STATE_PLAYING);
@@ -576,6 +674,7 @@ void koto_playback_engine_pause(KotoPlaybackEngine * self) {
 
 	self->is_playing = FALSE;
 	gst_element_change_state(self->player, GST_STATE_CHANGE_PLAYING_TO_PAUSED);
+	koto_playback_engine_update_track_position(self); // Remember where we paused
 	koto_update_mpris_playback_state(GST_STATE_PAUSED);
 }
 
@@ -633,6 +732,7 @@ void koto_playback_engine_set_track_repeat(
 	gboolean enable_repeat
 ) {
 	self->is_repeat_enabled = enable_repeat;
+	koto_playback_engine_prepare_next_track(self); // What comes next depends on repeat
 	g_signal_emit(self, playback_engine_signals[SIGNAL_TRACK_REPEAT_CHANGE], 0); // Emit our track repeat changed event
 }
 
@@ -652,6 +752,7 @@ void koto_playback_engine_set_track_shuffle(
 
 	self->is_shuffle_enabled = enable_shuffle;
 	g_object_set(playlist, "is-shuffle-enabled", self->is_shuffle_enabled, NULL); // Set the is-shuffle-enabled on any existing playlist
+	koto_playback_engine_prepare_next_track(self); // What comes next depends on shuffle
 	g_signal_emit(self, playback_engine_signals[SIGNAL_TRACK_SHUFFLE_CHANGE], 0); // Emit our track shuffle changed event
 }
 
@@ -691,6 +792,14 @@ void koto_playback_engine_set_track_by_uuid(
 	koto_playback_engine_play(self); // Play the new track
 	koto_playback_engine_set_volume(self, self->volume); // Re-enforce our volume on the updated playbin
 
+	koto_playback_engine_announce_track(self);
+}
+
+static void koto_playback_engine_announce_track(KotoPlaybackEngine * self) {
+	KotoTrack * track = self->current_track;
+
+	koto_playback_engine_prepare_next_track(self); // Have the following track ready for a gapless transition
+
 	GVariant * metadata = koto_track_get_metadata_vardict(track); // Get the GVariantBuilder variable dict for the metadata
 	GVariantDict * metadata_dict = g_variant_dict_new(metadata);
 
@@ -757,6 +866,11 @@ void koto_playback_engine_stop(KotoPlaybackEngine * self) {
 	}
 
 	gst_element_set_state(self->player, GST_STATE_NULL);
+
+	g_mutex_lock(&self->next_lock);
+	g_clear_pointer(&self->queued_uuid, g_free); // Anything playbin had queued went away with the pipeline
+	g_mutex_unlock(&self->next_lock);
+
 	GstPad * pad = gst_element_get_static_pad(self->player, "sink"); // Get the static pad of the audio element
 
 	if (!GST_IS_PAD(pad)) {
@@ -781,44 +895,20 @@ void koto_playback_engine_toggle(KotoPlaybackEngine * self) {
 	koto_current_playlist_save_playlist_state(current_playlist); // Save the playlist state during pause and play in case we are doing that remotely
 }
 
-gboolean koto_playback_engine_tick_duration(gpointer user_data) {
-	KotoPlaybackEngine * self = user_data;
-
+void koto_playback_engine_tick_duration(KotoPlaybackEngine * self) {
 	if (!KOTO_IS_PLAYBACK_ENGINE(self)) {
-		return FALSE;
-	}
-
-	if (self->is_playing) { // Is playing
-		g_signal_emit(self, playback_engine_signals[SIGNAL_TICK_DURATION], 0); // Emit our 1s track tick
-	} else { // Not playing so exiting timer
-		self->tick_duration_timer_running = FALSE;
+		return;
 	}
 
-	return self->is_playing;
+	g_signal_emit(self, playback_engine_signals[SIGNAL_TICK_DURATION], 0); // Emit our duration tick
 }
 
-gboolean koto_playback_engine_tick_track(gpointer user_data) {
-	KotoPlaybackEngine * self = user_data;
-
+void koto_playback_engine_tick_track(KotoPlaybackEngine * self) {
 	if (!KOTO_IS_PLAYBACK_ENGINE(self)) {
-		return FALSE;
-	}
-
-	if (self->is_playing) { // Is playing
-		KotoPlaylist * playlist = koto_current_playlist_get_playlist(current_playlist);
-
-		if (KOTO_IS_PLAYLIST(playlist)) {
-			koto_playlist_emit_modified(playlist); // Emit modified on the playlist to update UI in realtime (ish, okay? every 100ms is enough geez)
-		}
-
-		g_signal_emit(self, playback_engine_signals[SIGNAL_TICK_TRACK], 0); // Emit our 100ms track tick
-	} else {
-		self->tick_track_timer_running = FALSE;
+		return;
 	}
 
-	koto_playback_engine_update_track_position(self); // Update track position if needed
-
-	return self->is_playing;
+	g_signal_emit(self, playback_engine_signals[SIGNAL_TICK_TRACK], 0); // Emit our track tick, only when the position jumped rather than on a timer
 }
 
 gboolean koto_playback_engine_tick_update_playlist_state(gpointer user_data) {
@@ -829,7 +919,14 @@ gboolean koto_playback_engine_tick_update_playlist_state(gpointer user_data) {
 	}
 
 	if (self->is_playing) { // Is playing
+		koto_playback_engine_update_track_position(self); // Update track position
 		koto_current_playlist_save_playlist_state(current_playlist); // Save the state of the current playlist
+
+		KotoPlaylist * playlist = koto_current_playlist_get_playlist(current_playlist);
+
+		if (KOTO_IS_PLAYLIST(playlist)) {
+			koto_playlist_emit_modified(playlist); // Let views showing the saved position catch up at the same slow pace
+		}
 	} else {
 		self->tick_update_playlist_state = FALSE;
 	}
@@ -144,8 +144,8 @@ void koto_playback_engine_update_duration(KotoPlaybackEngine * self);
 
 void koto_playback_engine_update_track_position(KotoPlaybackEngine * self);
 
-gboolean koto_playback_engine_tick_duration(gpointer user_data);
+void koto_playback_engine_tick_duration(KotoPlaybackEngine * self);
 
-gboolean koto_playback_engine_tick_track(gpointer user_data);
+void koto_playback_engine_tick_track(KotoPlaybackEngine * self);
 
 gboolean koto_playback_engine_tick_update_playlist_state(gpointer user_data);
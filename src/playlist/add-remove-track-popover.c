@@ -141,23 +141,27 @@ void koto_add_remove_track_popover_handle_checkbutton_toggle(
 		return;
 	}
 
+	GPtrArray * tracks_to_add = g_ptr_array_new();
 	GList * pos;
 
 	for (pos = self->tracks; pos != NULL; pos = pos->next) { // Iterate over our KotoTracks
 		KotoTrack * track = pos->data;
 
-		if (!KOTO_TRACK(track)) { // Not a track
+		if (!KOTO_IS_TRACK(track)) { // Not a track
 			continue; // Skip this
 		}
 
 		if (should_add) { // Should be adding
-			koto_playlist_add_track(playlist, track, FALSE, TRUE); // Add the track to the playlist
+			g_ptr_array_add(tracks_to_add, track); // Add them all at once below
 		} else { // Should be removing
 			gchar * track_uuid = koto_track_get_uuid(track); // Get the track
 			koto_playlist_remove_track_by_uuid(playlist, track_uuid); // Remove the track from the playlist
 		}
 	}
 
+	koto_playlist_add_tracks(playlist, tracks_to_add, TRUE); // Add the tracks to the playlist in one go
+	g_ptr_array_unref(tracks_to_add);
+
 	gtk_popover_popdown(GTK_POPOVER(self)); // Temporary to hopefully prevent a bork
 }
 
@@ -230,14 +234,12 @@ void koto_add_remove_track_popover_set_tracks(
 	}
 
 	self->tracks = g_list_copy(tracks);
-	GHashTable * playlists = koto_cartographer_get_playlists(koto_maps); // Get our playlists
-	GHashTableIter playlists_iter;
-	gpointer uuid, playlist_ptr;
-
-	g_hash_table_iter_init(&playlists_iter, playlists); // Init our HashTable iterator
+	GList * playlists = koto_cartographer_get_playlists(koto_maps); // Get our playlists
+	GList * cur_playlist;
 
-	while (g_hash_table_iter_next(&playlists_iter, &uuid, &playlist_ptr)) { // While we are iterating through our playlists
-		KotoPlaylist * playlist = playlist_ptr;
+	for (cur_playlist = playlists; cur_playlist != NULL; cur_playlist = cur_playlist->next) { // While we are iterating through our playlists
+		KotoPlaylist * playlist = cur_playlist->data;
+		gchar * uuid = koto_playlist_get_uuid(playlist);
 		gboolean should_be_checked = FALSE;
 
 		if (tracks_len > 1) { // More than one track
@@ -267,7 +269,11 @@ void koto_add_remove_track_popover_set_tracks(
 			gtk_check_button_set_active(playlist_check, should_be_checked); // Set active to our should_be_checked bool
 			g_signal_handler_unblock(playlist_check, check_button_sig_id); // Unblock the signal
 		}
+
+		g_free(uuid);
 	}
+
+	g_list_free(playlists);
 }
 
 KotoAddRemoveTrackPopover * koto_add_remove_track_popover_new() {
@@ -18,11 +18,14 @@
 #include <glib-2.0/glib.h>
 #include <glib-2.0/gio/gio.h>
 #include <magic.h>
+#include <string.h>
 #include "../db/cartographer.h"
 #include "../db/db.h"
 #include "../koto-utils.h"
 #include "playlist.h"
 
+#define KOTO_PLAYLIST_TRACKS_PER_INSERT 500
+
 extern KotoCartographer * koto_maps;
 extern sqlite3 * koto_db;
 
@@ -40,6 +43,7 @@ enum {
 enum {
 	SIGNAL_MODIFIED,
 	SIGNAL_TRACK_ADDED,
+	SIGNAL_TRACKS_ADDED,
 	SIGNAL_TRACK_LOAD_FINALIZED,
 	SIGNAL_TRACK_REMOVED,
 	N_SIGNALS
@@ -60,13 +64,24 @@ struct _KotoPlaylist {
 	gboolean is_shuffle_enabled;
 	gboolean finalized;
 
-	GListStore * store;
-	GQueue * sorted_tracks;
+	GPtrArray * sorted_tracks; // Tracks in the order of our current model, which is what we expose as our GListModel
+	GHashTable * sorted_positions; // Track UUID to its position in sorted_tracks, offset by one so NULL means not found
+	guint sorted_positions_valid; // Positions below this are accurate, the rest are rebuilt when next looked up
+
+	GPtrArray * tracks; // This is effectively our vanilla value that should never change
+	GHashTable * track_sequences; // Track UUID to the order it was added in, offset by one so NULL means not found
+	guint next_sequence;
 
-	GQueue * tracks; // This is effectively our vanilla value that should never change
-	GQueue * played_tracks;
+	GPtrArray * shuffled_tracks; // Track UUIDs in shuffled order, walked as a cycle so every track plays before any repeats. NULL until needed
+	guint32 shuffle_seed; // Seeds our permutation so it can be regenerated identically, 0 until first shuffled
+	gint shuffle_position; // Position of the current track in shuffled_tracks
 };
 
+typedef struct {
+	KotoTrack * track;
+	const gchar * key; // Collation key for models sorting by name, owned by the track, album or artist. NULL for other models
+} KotoPlaylistSortEntry;
+
 struct _KotoPlaylistClass {
 	GObjectClass parent_class;
 
@@ -75,6 +90,10 @@ struct _KotoPlaylistClass {
 		KotoPlaylist * playlist,
 		gchar * track_uuid
 	);
+	void (* tracks_added) (
+		KotoPlaylist * playlist,
+		GPtrArray * track_uuids
+	);
 	void (* track_load_finalized) (KotoPlaylist * playlist);
 	void (* track_removed) (
 		KotoPlaylist * playlist,
@@ -82,7 +101,9 @@ struct _KotoPlaylistClass {
 	);
 };
 
-G_DEFINE_TYPE(KotoPlaylist, koto_playlist, G_TYPE_OBJECT);
+static void koto_playlist_list_model_init(GListModelInterface * iface);
+
+G_DEFINE_TYPE_WITH_CODE(KotoPlaylist, koto_playlist, G_TYPE_OBJECT, G_IMPLEMENT_INTERFACE(G_TYPE_LIST_MODEL, koto_playlist_list_model_init));
 
 static GParamSpec * props[N_PROPERTIES] = {
 	NULL
@@ -188,6 +209,19 @@ static void koto_playlist_class_init(KotoPlaylistClass * c) {
 		G_TYPE_CHAR
 	);
 
+	playlist_signals[SIGNAL_TRACKS_ADDED] = g_signal_new(
+		"tracks-added",
+		G_TYPE_FROM_CLASS(gobject_class),
+		G_SIGNAL_RUN_FIRST | G_SIGNAL_ACTION,
+		G_STRUCT_OFFSET(KotoPlaylistClass, tracks_added),
+		NULL,
+		NULL,
+		NULL,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_PTR_ARRAY
+	);
+
 	playlist_signals[SIGNAL_TRACK_LOAD_FINALIZED] = g_signal_new(
 		"track-load-finalized",
 		G_TYPE_FROM_CLASS(gobject_class),
@@ -288,31 +322,361 @@ static void koto_playlist_init(KotoPlaylist * self) {
 	self->ephemeral = FALSE;
 	self->finalized = FALSE;
 
-	self->tracks = g_queue_new(); // Set as an empty GQueue
-	self->played_tracks = g_queue_new(); // Set as an empty GQueue
-	self->sorted_tracks = g_queue_new(); // Set as an empty GQueue
-	self->store = g_list_store_new(KOTO_TYPE_TRACK);
+	self->tracks = g_ptr_array_new(); // UUIDs are owned by their tracks
+	self->track_sequences = g_hash_table_new(g_str_hash, g_str_equal);
+	self->next_sequence = 0;
+	self->shuffled_tracks = NULL; // Generated when we first shuffle
+	self->shuffle_seed = 0;
+	self->shuffle_position = -1;
+	self->sorted_tracks = g_ptr_array_new_with_free_func(g_object_unref); // Holds our refs to the tracks, which own the UUIDs we use as keys
+	self->sorted_positions = g_hash_table_new(g_str_hash, g_str_equal);
+	self->sorted_positions_valid = 0;
+}
+
+static GType koto_playlist_list_model_get_item_type(GListModel * model) {
+	(void) model;
+	return KOTO_TYPE_TRACK;
+}
+
+static guint koto_playlist_list_model_get_n_items(GListModel * model) {
+	return KOTO_PLAYLIST(model)->sorted_tracks->len;
 }
 
-void koto_playlist_add_to_played_tracks(
+static gpointer koto_playlist_list_model_get_item(
+	GListModel * model,
+	guint position
+) {
+	KotoPlaylist * self = KOTO_PLAYLIST(model);
+
+	if (position >= self->sorted_tracks->len) { // Out of bounds
+		return NULL;
+	}
+
+	return g_object_ref(g_ptr_array_index(self->sorted_tracks, position));
+}
+
+static void koto_playlist_list_model_init(GListModelInterface * iface) {
+	iface->get_item_type = koto_playlist_list_model_get_item_type;
+	iface->get_n_items = koto_playlist_list_model_get_n_items;
+	iface->get_item = koto_playlist_list_model_get_item;
+}
+
+/**
+ * Mark the positions of every track at or after from as stale. Nothing before a change moves, so those positions stay valid and we only rebuild the rest once a position is next looked up.
+ **/
+static void koto_playlist_invalidate_sorted_positions(
 	KotoPlaylist * self,
-	gchar * uuid
+	guint from
 ) {
-	if (!KOTO_IS_PLAYLIST(self)) {
+	self->sorted_positions_valid = MIN(self->sorted_positions_valid, from);
+}
+
+static gint koto_playlist_lookup_sorted_position(
+	KotoPlaylist * self,
+	const gchar * track_uuid
+) {
+	guint position = GPOINTER_TO_UINT(g_hash_table_lookup(self->sorted_positions, track_uuid)); // Position plus one, so zero is not found
+
+	if ((position != 0) && ((position - 1) < self->sorted_positions_valid)) { // Before any change, so still accurate
+		return (gint) position - 1;
+	}
+
+	if (self->sorted_positions_valid >= self->sorted_tracks->len) { // Everything is accurate, so we do not have this track
+		return -1;
+	}
+
+	for (guint i = self->sorted_positions_valid; i < self->sorted_tracks->len; i++) { // Rebuild from the earliest change onwards
+		g_hash_table_insert(self->sorted_positions, koto_track_get_uuid(g_ptr_array_index(self->sorted_tracks, i)), GUINT_TO_POINTER(i + 1)); // Position plus one
+	}
+
+	self->sorted_positions_valid = self->sorted_tracks->len;
+	position = GPOINTER_TO_UINT(g_hash_table_lookup(self->sorted_positions, track_uuid));
+
+	return (gint) position - 1;
+}
+
+static gboolean koto_playlist_find_track_index(
+	KotoPlaylist * self,
+	guint sequence,
+	guint * index
+) {
+	guint low = 0;
+	guint high = self->tracks->len;
+
+	while (low < high) { // Tracks are always in the order they were added, so binary search on their sequence
+		guint mid = low + (high - low) / 2;
+		guint mid_sequence = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, g_ptr_array_index(self->tracks, mid)));
+
+		if (mid_sequence == sequence) { // Found it
+			*index = mid;
+			return TRUE;
+		} else if (mid_sequence < sequence) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return FALSE;
+}
+
+static gchar * koto_playlist_get_sorted_uuid_at(
+	KotoPlaylist * self,
+	gint position
+) {
+	if ((position < 0) || ((guint) position >= self->sorted_tracks->len)) { // Out of bounds
+		return NULL;
+	}
+
+	return koto_track_get_uuid(g_ptr_array_index(self->sorted_tracks, (guint) position));
+}
+
+static const gchar * koto_playlist_get_collation_key_for_model(
+	KotoTrack * track,
+	KotoPreferredPlaylistSortType model
+) {
+	if (model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_TRACK_NAME) { // Track name
+		return koto_track_get_name_collation_key(track);
+	}
+
+	if ((model != KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ALBUM) && (model != KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ARTIST)) { // Not sorted by name
+		return NULL;
+	}
+
+	gboolean by_album = (model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ALBUM);
+	gchar * uuid = NULL;
+
+	g_object_get(
+		track,
+		by_album ? "album-uuid" : "artist-uuid",
+		&uuid,
+		NULL
+	);
+
+	const gchar * key = "";
+
+	if (koto_utils_string_is_valid(uuid)) { // Have a UUID to look up
+		key = by_album ? koto_album_get_name_collation_key(koto_cartographer_get_album_by_uuid(koto_maps, uuid)) : koto_artist_get_name_collation_key(koto_cartographer_get_artist_by_uuid(koto_maps, uuid));
+	}
+
+	g_free(uuid);
+	return key;
+}
+
+static void koto_playlist_invalidate_shuffle(KotoPlaylist * self) {
+	g_clear_pointer(&self->shuffled_tracks, g_ptr_array_unref); // Keep our seed so the regenerated permutation stays as close as possible
+	self->shuffle_position = -1;
+}
+
+static void koto_playlist_find_shuffle_position(KotoPlaylist * self) {
+	self->shuffle_position = -1;
+
+	if ((self->shuffled_tracks == NULL) || !koto_utils_string_is_valid(self->current_uuid)) { // No permutation or nothing playing yet
 		return;
 	}
 
-	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, uuid);
+	for (guint i = 0; i < self->shuffled_tracks->len; i++) { // Find where our current track is in the shuffled order
+		if (g_strcmp0(g_ptr_array_index(self->shuffled_tracks, i), self->current_uuid) == 0) {
+			self->shuffle_position = (gint) i;
+			break;
+		}
+	}
+}
+
+/**
+ * Add a track to our existing shuffled order at a random point after our current track, so what has already played stays where it is.
+ **/
+static void koto_playlist_shuffle_in_track(
+	KotoPlaylist * self,
+	gchar * track_uuid
+) {
+	if (self->shuffled_tracks == NULL) { // No permutation yet, it will include this track once generated
+		return;
+	}
 
-	if (!KOTO_IS_TRACK(track)) {
+	gint32 first_unplayed = self->shuffle_position + 1;
+	guint index = (guint) g_random_int_range(first_unplayed, (gint32) self->shuffled_tracks->len + 1);
+	g_ptr_array_insert(self->shuffled_tracks, (gint) index, track_uuid);
+}
+
+/**
+ * Remove a track from our existing shuffled order without reshuffling the rest of it.
+ **/
+static void koto_playlist_shuffle_out_track(
+	KotoPlaylist * self,
+	const gchar * track_uuid
+) {
+	if (self->shuffled_tracks == NULL) { // No permutation yet
 		return;
 	}
 
-	if (koto_playlist_get_position_of_track(self, track) != -1) { // Already added
+	for (guint i = 0; i < self->shuffled_tracks->len; i++) {
+		if (g_strcmp0(g_ptr_array_index(self->shuffled_tracks, i), track_uuid) != 0) { // Not this track
+			continue;
+		}
+
+		g_ptr_array_remove_index(self->shuffled_tracks, i); // Keep the rest in order
+
+		if ((gint) i <= self->shuffle_position) { // Was played already or is our current track, so everything after it moved back by one
+			self->shuffle_position--;
+		}
+
+		break;
+	}
+}
+
+static void koto_playlist_ensure_shuffled_tracks(KotoPlaylist * self) {
+	if (self->shuffled_tracks != NULL) { // Already have a permutation
 		return;
 	}
 
-	g_queue_push_tail(self->played_tracks, uuid); // Add to end
+	if (self->shuffle_seed == 0) { // Never shuffled
+		self->shuffle_seed = (guint32) g_random_int_range(1, G_MAXINT32); // Non-zero so we know it is set
+
+		gchar * commit_op = g_strdup_printf("UPDATE playlist_meta SET shuffle_seed=%u WHERE id='%s';", self->shuffle_seed, self->uuid);
+		new_transaction(commit_op, "Failed to save our shuffle seed", FALSE); // Save now, since playback state is only saved for some playlists
+		g_free(commit_op);
+	}
+
+	guint len = self->tracks->len;
+	self->shuffled_tracks = g_ptr_array_sized_new(len);
+
+	for (guint i = 0; i < len; i++) { // Start from the order tracks were added in, so the permutation does not depend on the model
+		g_ptr_array_add(self->shuffled_tracks, g_ptr_array_index(self->tracks, i));
+	}
+
+	GRand * rand = g_rand_new_with_seed(self->shuffle_seed);
+
+	for (guint i = len; i > 1; i--) { // Fisher-Yates, swapping each position with one at or before it
+		guint j = (guint) g_rand_int_range(rand, 0, (gint32) i);
+		gpointer swap = self->shuffled_tracks->pdata[i - 1];
+		self->shuffled_tracks->pdata[i - 1] = self->shuffled_tracks->pdata[j];
+		self->shuffled_tracks->pdata[j] = swap;
+	}
+
+	g_rand_free(rand);
+	koto_playlist_find_shuffle_position(self); // Find where our current track landed, only done when regenerating
+}
+
+static gchar * koto_playlist_go_to_shuffled(
+	KotoPlaylist * self,
+	gint offset
+) {
+	koto_playlist_ensure_shuffled_tracks(self);
+
+	gint len = (gint) self->shuffled_tracks->len;
+
+	if (len == 0) { // No tracks
+		return NULL;
+	}
+
+	if (self->shuffle_position == -1) { // Not started yet
+		self->shuffle_position = (offset > 0) ? 0 : len - 1;
+	} else { // Step around the cycle
+		self->shuffle_position = (self->shuffle_position + offset + len) % len;
+	}
+
+	self->current_uuid = g_ptr_array_index(self->shuffled_tracks, (guint) self->shuffle_position);
+	self->current_position = koto_playlist_get_position_of_track(self, koto_cartographer_get_track_by_uuid(koto_maps, self->current_uuid)); // Keep our position in the model accurate
+
+	koto_playlist_emit_modified(self);
+
+	return self->current_uuid;
+}
+
+static gint koto_playlist_model_sort_entries(
+	gconstpointer first_item,
+	gconstpointer second_item,
+	gpointer data_list
+) {
+	const KotoPlaylistSortEntry * first_entry = first_item;
+	const KotoPlaylistSortEntry * second_entry = second_item;
+
+	gint result = ((first_entry->key != NULL) && (second_entry->key != NULL)) ? strcmp(first_entry->key, second_entry->key) : koto_playlist_model_sort_by_track(first_entry->track, second_entry->track, data_list); // When sorting by name, our keys are all we need
+
+	if (result != 0) { // Not equal
+		return result;
+	}
+
+	KotoPlaylist * self = g_list_nth_data(data_list, 0);
+	guint first_sequence = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, koto_track_get_uuid(first_entry->track)));
+	guint second_sequence = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, koto_track_get_uuid(second_entry->track)));
+
+	return (first_sequence < second_sequence) ? -1 : ((first_sequence > second_sequence) ? 1 : 0); // Fall back to the order they were added in, so inserting one track lands where a full sort would put it
+}
+
+static guint koto_playlist_find_sorted_position(
+	KotoPlaylist * self,
+	KotoTrack * track
+) {
+	GList * sort_user_data = NULL;
+
+	sort_user_data = g_list_prepend(sort_user_data, GUINT_TO_POINTER(self->model));
+	sort_user_data = g_list_prepend(sort_user_data, self);
+
+	KotoPlaylistSortEntry entry = {
+		track, koto_playlist_get_collation_key_for_model(track, self->model)
+	};
+
+	guint low = 0;
+	guint high = self->sorted_tracks->len;
+
+	while (low < high) { // Binary search for the first track that sorts after this one
+		guint mid = low + (high - low) / 2;
+		KotoTrack * mid_track = g_ptr_array_index(self->sorted_tracks, mid);
+		KotoPlaylistSortEntry mid_entry = {
+			mid_track, koto_playlist_get_collation_key_for_model(mid_track, self->model)
+		};
+
+		if (koto_playlist_model_sort_entries(&entry, &mid_entry, sort_user_data) < 0) { // Sorts before the middle
+			high = mid;
+		} else {
+			low = mid + 1;
+		}
+	}
+
+	g_list_free(sort_user_data);
+	return low;
+}
+
+static gboolean koto_playlist_sort_tracks(
+	KotoPlaylist * self,
+	KotoPreferredPlaylistSortType preferred_model
+) {
+	GList * sort_user_data = NULL;
+
+	sort_user_data = g_list_prepend(sort_user_data, GUINT_TO_POINTER(preferred_model)); // Prepend our preferred model first
+	sort_user_data = g_list_prepend(sort_user_data, self); // Prepend ourself
+
+	guint len = self->sorted_tracks->len;
+	KotoPlaylistSortEntry * entries = g_new0(KotoPlaylistSortEntry, len);
+
+	for (guint i = 0; i < len; i++) { // For each track
+		entries[i].track = g_ptr_array_index(self->sorted_tracks, i); // Our sorted tracks hold the ref for us
+		entries[i].key = koto_playlist_get_collation_key_for_model(entries[i].track, preferred_model); // Look up the key once rather than on every comparison
+	}
+
+	g_qsort_with_data(entries, (gint) len, sizeof(KotoPlaylistSortEntry), koto_playlist_model_sort_entries, sort_user_data); // Sort the tracks once
+
+	gboolean changed = FALSE;
+
+	for (guint i = 0; i < len; i++) { // For each sorted track
+		if (self->sorted_tracks->pdata[i] != entries[i].track) { // Moved
+			self->sorted_tracks->pdata[i] = entries[i].track;
+			changed = TRUE;
+		}
+	}
+
+	g_free(entries);
+	g_list_free(sort_user_data);
+
+	self->model = preferred_model; // Update our preferred model
+
+	if (changed) { // Order changed
+		koto_playlist_invalidate_sorted_positions(self, 0);
+	}
+
+	return changed;
 }
 
 void koto_playlist_add_track(
@@ -331,25 +695,28 @@ void koto_playlist_add_track(
 
 	gchar * track_uuid = koto_track_get_uuid(track);
 
-	if (koto_playlist_get_position_of_track(self, track) != -1) { // Found already
+	if (g_hash_table_contains(self->track_sequences, track_uuid)) { // Found already
 		return;
 	}
 
-	g_queue_push_tail(self->tracks, track_uuid); // Prepend the UUID to the tracks
-	g_queue_push_tail(self->sorted_tracks, track_uuid); // Also add to our sorted tracks
-	g_list_store_append(self->store, track); // Add to the store
+	self->next_sequence++;
+	g_ptr_array_add(self->tracks, track_uuid); // Add the UUID to the end of the tracks
+	g_hash_table_insert(self->track_sequences, track_uuid, GUINT_TO_POINTER(self->next_sequence));
 
-	if (self->finalized) { // Is already finalized
-		koto_playlist_apply_model(self, self->model); // Re-apply our current model to ensure our "sorted tracks" is sorted, as is our GLIstStore used in the playlist page
-	}
+	guint position = self->finalized ? koto_playlist_find_sorted_position(self, track) : self->sorted_tracks->len; // Insert where our model puts it, or at the end while loading since we sort once finalized
+	g_ptr_array_insert(self->sorted_tracks, (gint) position, g_object_ref(track));
+	koto_playlist_invalidate_sorted_positions(self, position);
+	koto_playlist_shuffle_in_track(self, track_uuid);
+
+	g_list_model_items_changed(G_LIST_MODEL(self), position, 0, 1); // Only this one row changed
 
 	if (commit_to_table) {
 		koto_track_save_to_playlist(track, self->uuid); // Call to save the playlist to the track
 	}
 
-	if (current && (g_queue_get_length(self->tracks) > 1)) { // Is current and NOT the first item
+	if (current && (self->tracks->len > 1)) { // Is current and NOT the first item
 		self->current_uuid = track_uuid; // Mark this as current UUID
-		koto_playlist_apply_model(self, self->model); // Re-apply our model to enforce mass sort
+		self->current_position = (gint) position;
 	}
 
 	g_signal_emit(
@@ -360,19 +727,96 @@ void koto_playlist_add_track(
 	);
 }
 
-void koto_playlist_apply_model(
+void koto_playlist_add_tracks(
 	KotoPlaylist * self,
-	KotoPreferredPlaylistSortType preferred_model
+	GPtrArray * tracks,
+	gboolean commit_to_table
 ) {
-	GList * sort_user_data = NULL;
+	if (!KOTO_IS_PLAYLIST(self)) {
+		return;
+	}
 
-	sort_user_data = g_list_prepend(sort_user_data, GUINT_TO_POINTER(preferred_model)); // Prepend our preferred model first
-	sort_user_data = g_list_prepend(sort_user_data, self); // Prepend ourself
+	if ((tracks == NULL) || (tracks->len == 0)) { // Nothing to add
+		return;
+	}
 
-	g_queue_sort(self->sorted_tracks, koto_playlist_model_sort_by_uuid, sort_user_data); // Sort tracks, which is by UUID
-	g_list_store_sort(self->store, koto_playlist_model_sort_by_track, sort_user_data); // Sort tracks by indexed tracks
+	guint previous_len = self->sorted_tracks->len;
+	GPtrArray * added_uuids = g_ptr_array_sized_new(tracks->len);
 
-	self->model = preferred_model; // Update our preferred model
+	for (guint i = 0; i < tracks->len; i++) { // Single membership pass, which also skips duplicates within the tracks provided
+		KotoTrack * track = g_ptr_array_index(tracks, i);
+
+		if (!KOTO_IS_TRACK(track)) {
+			continue;
+		}
+
+		gchar * track_uuid = koto_track_get_uuid(track);
+
+		if (g_hash_table_contains(self->track_sequences, track_uuid)) { // Found already
+			continue;
+		}
+
+		self->next_sequence++;
+		g_ptr_array_add(self->tracks, track_uuid);
+		g_hash_table_insert(self->track_sequences, track_uuid, GUINT_TO_POINTER(self->next_sequence));
+		g_ptr_array_add(self->sorted_tracks, g_object_ref(track)); // Append for now, we sort once below
+		g_ptr_array_add(added_uuids, track_uuid);
+	}
+
+	if (added_uuids->len == 0) { // Had all of these already
+		g_ptr_array_unref(added_uuids);
+		return;
+	}
+
+	for (guint i = 0; i < added_uuids->len; i++) { // Fit into our existing shuffled order rather than reshuffling what has played
+		koto_playlist_shuffle_in_track(self, g_ptr_array_index(added_uuids, i));
+	}
+
+	if (self->finalized && koto_playlist_sort_tracks(self, self->model)) { // Sorting moved existing tracks around
+		g_list_model_items_changed(G_LIST_MODEL(self), 0, previous_len, self->sorted_tracks->len);
+	} else { // Only appended
+		koto_playlist_invalidate_sorted_positions(self, previous_len);
+		g_list_model_items_changed(G_LIST_MODEL(self), previous_len, 0, added_uuids->len);
+	}
+
+	if (commit_to_table) { // Save all of these in one write, which the writer runs as one transaction
+		GString * commit_op = g_string_new(NULL);
+
+		for (guint i = 0; i < added_uuids->len; i++) { // For each track we added
+			if ((i % KOTO_PLAYLIST_TRACKS_PER_INSERT) == 0) { // Start a new statement, keeping each under SQLite's limits
+				g_string_append_printf(commit_op, "%sINSERT INTO playlist_tracks(playlist_id, track_id) VALUES", (i == 0) ? "" : ";");
+			} else {
+				g_string_append_c(commit_op, ',');
+			}
+
+			g_string_append_printf(commit_op, "('%s', '%s')", self->uuid, (gchar*) g_ptr_array_index(added_uuids, i));
+		}
+
+		g_string_append_c(commit_op, ';');
+		new_transaction(commit_op->str, "Failed to save tracks to playlist", FALSE);
+		g_string_free(commit_op, TRUE);
+	}
+
+	g_signal_emit(
+		self,
+		playlist_signals[SIGNAL_TRACKS_ADDED],
+		0,
+		added_uuids
+	);
+
+	g_ptr_array_unref(added_uuids);
+}
+
+void koto_playlist_apply_model(
+	KotoPlaylist * self,
+	KotoPreferredPlaylistSortType preferred_model
+) {
+	if (!koto_playlist_sort_tracks(self, preferred_model)) { // Already in this order, so nothing for views to do
+		return;
+	}
+
+	guint len = self->sorted_tracks->len;
+	g_list_model_items_changed(G_LIST_MODEL(self), 0, len, len); // Everything may have moved
 }
 
 void koto_playlist_commit(KotoPlaylist * self) {
@@ -406,16 +850,17 @@ void koto_playlist_commit(KotoPlaylist * self) {
 	}
 
 	gchar * commit_op = g_strdup_printf(
-		"INSERT INTO playlist_meta(id, name, art_path, preferred_model, album_id, track_id, playback_position_of_track)"
-		"VALUES('%s', quote(\"%s\"), quote(\"%s\"), %li, '%s', '%s', '%li')"
-		"ON CONFLICT(id) DO UPDATE SET name=excluded.name, art_path=excluded.art_path, preferred_model=excluded.preferred_model, album_id=excluded.album_id, track_id=excluded.track_id;",
+		"INSERT INTO playlist_meta(id, name, art_path, preferred_model, album_id, track_id, playback_position_of_track, shuffle_seed)"
+		"VALUES('%s', quote(\"%s\"), quote(\"%s\"), %li, '%s', '%s', '%li', %u)"
+		"ON CONFLICT(id) DO UPDATE SET name=excluded.name, art_path=excluded.art_path, preferred_model=excluded.preferred_model, album_id=excluded.album_id, track_id=excluded.track_id, shuffle_seed=excluded.shuffle_seed;",
 		self->uuid,
 		koto_utils_string_get_valid(self->name),
 		koto_utils_string_get_valid(self->art_path),
 		(guint64) self->model,
 		koto_utils_string_get_valid(self->album_uuid),
 		koto_utils_string_get_valid(self->current_uuid),
-		track_playback_pos
+		track_playback_pos,
+		self->shuffle_seed
 	);
 
 	new_transaction(commit_op, "Failed to save playlist", FALSE);
@@ -462,77 +907,59 @@ gboolean koto_playlist_get_is_hidden(KotoPlaylist * self) {
 }
 
 guint koto_playlist_get_length(KotoPlaylist * self) {
-	return KOTO_IS_PLAYLIST(self) ? g_queue_get_length(self->tracks) : 0; // Get the length of the tracks
+	return KOTO_IS_PLAYLIST(self) ? self->tracks->len : 0; // Get the length of the tracks
 }
 
 gchar * koto_playlist_get_name(KotoPlaylist * self) {
 	return (KOTO_IS_PLAYLIST(self) && koto_utils_string_is_valid(self->name)) ? g_strdup(self->name) : NULL;
 }
 
-gint koto_playlist_get_position_of_track(
-	KotoPlaylist * self,
-	KotoTrack * track
-) {
+gchar * koto_playlist_get_next_track_uuid(KotoPlaylist * self) {
 	if (!KOTO_IS_PLAYLIST(self)) {
-		return -1;
+		return NULL;
 	}
 
-	if (!G_IS_LIST_STORE(self->store)) {
-		return -1;
-	}
+	if (self->is_shuffle_enabled) { // Shuffling enabled
+		koto_playlist_ensure_shuffled_tracks(self);
 
-	if (!KOTO_IS_TRACK(track)) {
-		return -1;
-	}
+		guint len = self->shuffled_tracks->len;
 
-	gint position = -1;
-	guint found_pos = 0;
+		if (len == 0) { // No tracks
+			return NULL;
+		}
 
-	if (g_list_store_find(self->store, track, &found_pos)) { // Found the item
-		position = (gint) found_pos; // Cast our found position from guint to gint
+		return g_ptr_array_index(self->shuffled_tracks, (self->shuffle_position == -1) ? 0 : ((guint) self->shuffle_position + 1) % len); // Same step koto_playlist_go_to_next would take
 	}
 
-	return position;
-}
-
-gchar * koto_playlist_get_random_track(KotoPlaylist * self) {
-	gchar * track_uuid = NULL;
-	guint tracks_len = g_queue_get_length(self->sorted_tracks);
+	if (!koto_utils_string_is_valid(self->current_uuid)) { // No valid UUID yet
+		return koto_playlist_get_sorted_uuid_at(self, self->current_position + 1);
+	}
 
-	if (tracks_len == g_queue_get_length(self->played_tracks)) { // Played all tracks
-		track_uuid = g_list_nth_data(self->sorted_tracks->head, 0); // Get the first
-		g_queue_clear(self->played_tracks); // Clear our played tracks
-	} else { // Have not played all tracks
-		GRand * rando_calrissian = g_rand_new(); // Create a new RNG
-		guint attempt = 0;
+	gint pos_of_song = koto_playlist_get_position_of_track(self, koto_cartographer_get_track_by_uuid(koto_maps, self->current_uuid));
 
-		while (track_uuid == NULL) { // Haven't selected a track yet
-			attempt++;
-			gint32 selected_item = g_rand_int_range(rando_calrissian, 0, (gint32) tracks_len);
-			gchar * selected_track = g_queue_peek_nth(self->sorted_tracks, (guint) selected_item); // Get the UUID of the selected item
+	return koto_playlist_get_sorted_uuid_at(self, pos_of_song + 1); // NULL once we are at the end
+}
 
-			if (g_queue_index(self->played_tracks, selected_track) == -1) { // Haven't played the track
-				self->current_position = (gint) selected_item;
-				track_uuid = selected_track;
-				break;
-			} else { // Failed to get the track
-				if (attempt > tracks_len / 2) {
-					break; // Give up
-				}
-			}
-		}
+gint koto_playlist_get_position_of_track(
+	KotoPlaylist * self,
+	KotoTrack * track
+) {
+	if (!KOTO_IS_PLAYLIST(self)) {
+		return -1;
+	}
 
-		g_rand_free(rando_calrissian); // Free rando
+	if (!KOTO_IS_TRACK(track)) {
+		return -1;
 	}
 
-	return track_uuid;
+	return koto_playlist_lookup_sorted_position(self, koto_track_get_uuid(track));
 }
 
-GListStore * koto_playlist_get_store(KotoPlaylist * self) {
-	return self->store;
+guint32 koto_playlist_get_shuffle_seed(KotoPlaylist * self) {
+	return KOTO_IS_PLAYLIST(self) ? self->shuffle_seed : 0;
 }
 
-GQueue * koto_playlist_get_tracks(KotoPlaylist * self) {
+GPtrArray * koto_playlist_get_tracks(KotoPlaylist * self) {
 	return self->tracks;
 }
 
@@ -546,13 +973,7 @@ gchar * koto_playlist_go_to_next(KotoPlaylist * self) {
 	}
 
 	if (self->is_shuffle_enabled) { // Shuffling enabled
-		gchar * random_track_uuid = koto_playlist_get_random_track(self); // Get a random track
-		self->current_uuid = random_track_uuid; // Update our current UUID
-		koto_playlist_add_to_played_tracks(self, random_track_uuid);
-
-		koto_playlist_emit_modified(self);
-
-		return random_track_uuid;
+		return koto_playlist_go_to_shuffled(self, 1); // Next in our shuffled order
 	}
 
 	if (!koto_utils_string_is_valid(self->current_uuid)) { // No valid UUID yet
@@ -566,15 +987,14 @@ gchar * koto_playlist_go_to_next(KotoPlaylist * self) {
 
 		gint pos_of_song = koto_playlist_get_position_of_track(self, track); // Get the position of the current track based on the current model
 
-		if ((guint) pos_of_song == (g_queue_get_length(self->sorted_tracks) - 1)) { // At end
+		if ((guint) pos_of_song == (self->sorted_tracks->len - 1)) { // At end
 			return NULL;
 		}
 
 		self->current_position = pos_of_song + 1; // Increment our position based on position of song
 	}
 
-	self->current_uuid = g_queue_peek_nth(self->sorted_tracks, self->current_position);
-	koto_playlist_add_to_played_tracks(self, self->current_uuid);
+	self->current_uuid = koto_playlist_get_sorted_uuid_at(self, self->current_position);
 	koto_playlist_emit_modified(self);
 
 	return self->current_uuid;
@@ -582,7 +1002,7 @@ gchar * koto_playlist_go_to_next(KotoPlaylist * self) {
 
 gchar * koto_playlist_go_to_previous(KotoPlaylist * self) {
 	if (self->is_shuffle_enabled) { // Shuffling enabled
-		return koto_playlist_get_random_track(self); // Get a random track
+		return koto_utils_string_is_valid(self->current_uuid) ? koto_playlist_go_to_shuffled(self, -1) : NULL; // Back through our shuffled order
 	}
 
 	if (!koto_utils_string_is_valid(self->current_uuid)) { // No valid UUID
@@ -602,7 +1022,7 @@ gchar * koto_playlist_go_to_previous(KotoPlaylist * self) {
 	}
 
 	self->current_position = pos_of_song - 1; // Decrement our position based on position of song
-	self->current_uuid = g_queue_peek_nth(self->sorted_tracks, self->current_position);
+	self->current_uuid = koto_playlist_get_sorted_uuid_at(self, self->current_position);
 
 	koto_playlist_emit_modified(self);
 
@@ -651,14 +1071,14 @@ gint koto_playlist_model_sort_by_track(
 		(model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_DEFAULT) || // Newest first model
 		(model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_OLDEST_FIRST) // Oldest first
 	) {
-		gint first_track_pos = g_queue_index(self->tracks, koto_track_get_uuid(first_track));
-		gint second_track_pos = g_queue_index(self->tracks, koto_track_get_uuid(second_track));
+		guint first_track_pos = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, koto_track_get_uuid(first_track)));
+		guint second_track_pos = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, koto_track_get_uuid(second_track)));
 
-		if (first_track_pos == -1) { // First track isn't in tracks
+		if (first_track_pos == 0) { // First track isn't in tracks
 			return 1;
 		}
 
-		if (second_track_pos == -1) { // Second track isn't in tracks
+		if (second_track_pos == 0) { // Second track isn't in tracks
 			return -1;
 		}
 
@@ -703,7 +1123,7 @@ gint koto_playlist_model_sort_by_track(
 			return 0; // Just consider them as equal
 		}
 
-		return g_utf8_collate(koto_album_get_name(first_album), koto_album_get_name(second_album));
+		return strcmp(koto_album_get_name_collation_key(first_album), koto_album_get_name_collation_key(second_album));
 	}
 
 	if (model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ARTIST) { // Sort by artist name
@@ -734,9 +1154,9 @@ gint koto_playlist_model_sort_by_track(
 			return 0; // Just consider them as equal
 		}
 
-		return g_utf8_collate(koto_artist_get_name(first_artist), koto_artist_get_name(second_artist));
+		return strcmp(koto_artist_get_name_collation_key(first_artist), koto_artist_get_name_collation_key(second_artist));
 	} else if (model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_TRACK_NAME) { // Track name
-		return g_utf8_collate(koto_track_get_name(first_track), koto_track_get_name(second_track));
+		return strcmp(koto_track_get_name_collation_key(first_track), koto_track_get_name_collation_key(second_track));
 	} else if (model == KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_TRACK_POS) { // Sort by track position
 
 		guint first_track_disc = koto_track_get_disc_number(first_track);
@@ -761,13 +1181,6 @@ gint koto_playlist_model_sort_by_track(
 	return 0;
 }
 
-void koto_playlist_remove_from_played_tracks(
-	KotoPlaylist * self,
-	gchar * uuid
-) {
-	g_queue_remove(self->played_tracks, uuid);
-}
-
 void koto_playlist_remove_track_by_uuid(
 	KotoPlaylist * self,
 	gchar * uuid
@@ -776,16 +1189,25 @@ void koto_playlist_remove_track_by_uuid(
 		return;
 	}
 
-	gint file_index = g_queue_index(self->tracks, uuid); // Get the position of this uuid
+	guint sequence = GPOINTER_TO_UINT(g_hash_table_lookup(self->track_sequences, uuid)); // Get the order this uuid was added in
+	guint file_index = 0;
 
-	if (file_index != -1) { // Have in tracks
-		g_queue_pop_nth(self->tracks, file_index); // Remove nth where it is the file index
+	if ((sequence != 0) && koto_playlist_find_track_index(self, sequence, &file_index)) { // Have in tracks
+		g_ptr_array_remove_index(self->tracks, file_index); // Remove while keeping the rest in order
+		koto_playlist_shuffle_out_track(self, uuid);
 	}
 
-	gint file_index_in_sorted = g_queue_index(self->sorted_tracks, uuid); // Get position in sorted tracks
+	g_hash_table_remove(self->track_sequences, uuid);
+
+	gint position_in_sorted = koto_playlist_lookup_sorted_position(self, uuid); // Get position in sorted tracks
+
+	if (position_in_sorted != -1) { // Have in sorted tracks
+		guint position = (guint) position_in_sorted;
+		g_hash_table_remove(self->sorted_positions, uuid); // Remove before dropping our ref, since the track owns the key
+		g_ptr_array_remove_index(self->sorted_tracks, position);
+		koto_playlist_invalidate_sorted_positions(self, position); // Every track after it moved back by one
 
-	if (file_index_in_sorted != -1) { // Have in sorted tracks
-		g_queue_pop_nth(self->sorted_tracks, file_index_in_sorted); // Remove nth where it is the index in sorted tracks
+		g_list_model_items_changed(G_LIST_MODEL(self), position, 1, 0); // Only this one row changed
 	}
 
 	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, uuid); // Get the track
@@ -794,12 +1216,6 @@ void koto_playlist_remove_track_by_uuid(
 		return;
 	}
 
-	guint position = 0;
-
-	if (g_list_store_find(self->store, track, &position)) { // Got the position
-		g_list_store_remove(self->store, position); // Remove from the store
-	}
-
 	koto_track_remove_from_playlist(track, self->uuid);
 
 	g_signal_emit(
@@ -840,9 +1256,10 @@ void koto_playlist_save_current_playback_state(KotoPlaylist * self) {
 	}
 
 	gchar * commit_op = g_strdup_printf(
-		"UPDATE playlist_meta SET track_id='%s',  playback_position_of_track=%li WHERE id='%s';",
+		"UPDATE playlist_meta SET track_id='%s',  playback_position_of_track=%li, shuffle_seed=%u WHERE id='%s';",
 		koto_utils_string_get_valid(self->current_uuid),
 		koto_track_get_playback_position(track),
+		self->shuffle_seed,
 		self->uuid
 	);
 
@@ -945,6 +1362,22 @@ void koto_playlist_set_position(
 	}
 }
 
+void koto_playlist_set_shuffle_seed(
+	KotoPlaylist * self,
+	guint32 seed
+) {
+	if (!KOTO_IS_PLAYLIST(self)) { // Not a playlist
+		return;
+	}
+
+	if (self->shuffle_seed == seed) { // Same seed
+		return;
+	}
+
+	self->shuffle_seed = seed;
+	koto_playlist_invalidate_shuffle(self); // Regenerate from the new seed when next needed
+}
+
 void koto_playlist_set_track_as_current(
 	KotoPlaylist * self,
 	gchar * track_uuid
@@ -965,8 +1398,9 @@ void koto_playlist_set_track_as_current(
 		return;
 	}
 
-	self->current_uuid = track_uuid;
+	self->current_uuid = koto_track_get_uuid(track); // Owned by the track, unlike the UUID we were provided
 	self->current_position = position_of_track; // Set accurate position
+	koto_playlist_find_shuffle_position(self); // Find our new current track in the shuffled order we already have
 }
 
 void koto_playlist_set_uuid(
@@ -984,20 +1418,6 @@ void koto_playlist_set_uuid(
 	self->uuid = g_strdup(uuid); // Set the new UUID
 }
 
-void koto_playlist_tracks_queue_push_to_store(
-	gpointer data,
-	gpointer user_data
-) {
-	gchar * track_uuid = (gchar*) data;
-	KotoTrack * track = koto_cartographer_get_track_by_uuid(koto_maps, track_uuid);
-
-	if (!KOTO_IS_TRACK(track)) { // Not a track
-		return;
-	}
-
-	g_list_store_append(G_LIST_STORE(user_data), track);
-}
-
 void koto_playlist_unmap(KotoPlaylist * self) {
 	koto_cartographer_remove_playlist_by_uuid(koto_maps, self->uuid); // Remove from our cartographer
 }
@@ -53,11 +53,6 @@ KotoPlaylist * koto_playlist_new();
 
 KotoPlaylist * koto_playlist_new_with_uuid(const gchar * uuid);
 
-void koto_playlist_add_to_played_tracks(
-	KotoPlaylist * self,
-	gchar * uuid
-);
-
 void koto_playlist_add_track(
 	KotoPlaylist * self,
 	KotoTrack * track,
@@ -65,6 +60,12 @@ void koto_playlist_add_track(
 	gboolean commit_to_table
 );
 
+void koto_playlist_add_tracks(
+	KotoPlaylist * self,
+	GPtrArray * tracks,
+	gboolean commit_to_table
+);
+
 void koto_playlist_apply_model(
 	KotoPlaylist * self,
 	KotoPreferredPlaylistSortType preferred_model
@@ -90,14 +91,16 @@ gboolean koto_playlist_get_is_hidden(KotoPlaylist * self);
 
 gchar * koto_playlist_get_name(KotoPlaylist * self);
 
+gchar * koto_playlist_get_next_track_uuid(KotoPlaylist * self);
+
 gint koto_playlist_get_position_of_track(
 	KotoPlaylist * self,
 	KotoTrack * track
 );
 
-GListStore * koto_playlist_get_store(KotoPlaylist * self);
+guint32 koto_playlist_get_shuffle_seed(KotoPlaylist * self);
 
-GQueue * koto_playlist_get_tracks(KotoPlaylist * self);
+GPtrArray * koto_playlist_get_tracks(KotoPlaylist * self);
 
 gchar * koto_playlist_get_uuid(KotoPlaylist * self);
 
@@ -119,11 +122,6 @@ gint koto_playlist_model_sort_by_track(
 	gpointer model_ptr
 );
 
-void koto_playlist_remove_from_played_tracks(
-	KotoPlaylist * self,
-	gchar * uuid
-);
-
 void koto_playlist_remove_track_by_uuid(
 	KotoPlaylist * self,
 	gchar * uuid
@@ -151,6 +149,11 @@ void koto_playlist_set_position(
 	gint position
 );
 
+void koto_playlist_set_shuffle_seed(
+	KotoPlaylist * self,
+	guint32 seed
+);
+
 void koto_playlist_set_track_as_current(
 	KotoPlaylist * self,
 	gchar * track_uuid
@@ -161,11 +164,6 @@ void koto_playlist_set_uuid(
 	const gchar * uuid
 );
 
-void koto_playlist_tracks_queue_push_to_store(
-	gpointer data,
-	gpointer user_data
-);
-
 void koto_playlist_unmap(KotoPlaylist * self);
 
 G_END_DECLS
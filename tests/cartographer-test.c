@@ -0,0 +1,164 @@
+/* cartographer-test.c
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib-2.0/glib.h>
+#include <gtk-4.0/gtk/gtk.h>
+#include <magic.h>
+#include "../src/db/cartographer.h"
+#include "../src/indexer/structs.h"
+
+#define KOTO_TEST_ARTISTS 8
+#define KOTO_TEST_WRITERS 4
+#define KOTO_TEST_READERS 4
+#define KOTO_TEST_TRACKS_PER_WRITER 2000
+#define KOTO_TEST_BATCH_SIZE 50
+
+extern KotoCartographer * koto_maps;
+
+GVolumeMonitor * volume_monitor = NULL; // Normally defined by main.c, which we do not link
+GtkApplication * app = NULL;
+GtkWindow * main_window = NULL;
+magic_t magic_cookie = NULL;
+
+typedef struct {
+	GPtrArray * tracks[KOTO_TEST_WRITERS]; // Tracks each writer adds, in the order they are added
+	gchar ** keys[KOTO_TEST_WRITERS]; // Uniqueish key expected for each track
+	KotoArtist * artists[KOTO_TEST_ARTISTS];
+	gint writers_running;
+} KotoCartographerTest;
+
+typedef struct {
+	KotoCartographerTest * test;
+	guint index;
+} KotoCartographerTestWorker;
+
+static gpointer koto_cartographer_test_writer(gpointer user_data) {
+	KotoCartographerTestWorker * worker = user_data;
+	GPtrArray * tracks = worker->test->tracks[worker->index];
+
+	for (guint start = 0; start < tracks->len; start += KOTO_TEST_BATCH_SIZE) { // Add in batches, as the indexer does
+		guint end = MIN(start + KOTO_TEST_BATCH_SIZE, tracks->len);
+
+		if ((start / KOTO_TEST_BATCH_SIZE) % 4 == 3) { // Mix in single inserts, which race the batches for the same lock
+			for (guint i = start; i < end; i++) {
+				koto_cartographer_add_track(koto_maps, g_ptr_array_index(tracks, i));
+			}
+
+			continue;
+		}
+
+		GPtrArray * batch = g_ptr_array_sized_new(end - start);
+
+		for (guint i = start; i < end; i++) {
+			g_ptr_array_add(batch, g_ptr_array_index(tracks, i));
+		}
+
+		koto_cartographer_add_tracks(koto_maps, batch);
+		g_ptr_array_unref(batch);
+	}
+
+	(void) g_atomic_int_dec_and_test(&worker->test->writers_running); // Let our readers know once the last writer is done
+	return NULL;
+}
+
+static gpointer koto_cartographer_test_reader(gpointer user_data) {
+	KotoCartographerTestWorker * worker = user_data;
+	KotoCartographerTest * test = worker->test;
+	GRand * rand = g_rand_new_with_seed(worker->index);
+
+	while (g_atomic_int_get(&test->writers_running) > 0) { // Keep looking things up for as long as tracks are being added
+		guint writer = (guint) g_rand_int_range(rand, 0, KOTO_TEST_WRITERS);
+		guint i = (guint) g_rand_int_range(rand, 0, KOTO_TEST_TRACKS_PER_WRITER);
+		KotoTrack * expected = g_ptr_array_index(test->tracks[writer], i);
+
+		KotoTrack * by_uuid = koto_cartographer_get_track_by_uuid(koto_maps, koto_track_get_uuid(expected));
+		g_assert_true((by_uuid == NULL) || (by_uuid == expected)); // Either not added yet or exactly our track
+
+		KotoTrack * by_key = koto_cartographer_get_track_by_uniqueish_key(koto_maps, test->keys[writer][i]);
+		g_assert_true((by_key == NULL) || (by_key == expected));
+
+		if (by_key != NULL) { // Indexed by key, so the uuid must already be there too
+			g_assert_true(koto_cartographer_has_track_by_uuid(koto_maps, koto_track_get_uuid(expected)));
+		}
+
+		KotoArtist * artist = test->artists[i % KOTO_TEST_ARTISTS];
+		g_assert_true(koto_cartographer_get_artist_by_uuid(koto_maps, koto_artist_get_uuid(artist)) == artist);
+	}
+
+	g_rand_free(rand);
+	return NULL;
+}
+
+static void test_cartographer_concurrent_inserts_and_lookups() {
+	KotoCartographerTest * test = g_new0(KotoCartographerTest, 1);
+	koto_maps = koto_cartographer_new();
+
+	for (guint i = 0; i < KOTO_TEST_ARTISTS; i++) { // Artists are added up front, since track keys look them up
+		gchar * name = g_strdup_printf("Artist %u", i);
+		test->artists[i] = koto_artist_new(name);
+		koto_cartographer_add_artist(koto_maps, test->artists[i]);
+		g_free(name);
+	}
+
+	for (guint writer = 0; writer < KOTO_TEST_WRITERS; writer++) {
+		test->tracks[writer] = g_ptr_array_new_with_free_func(g_object_unref);
+		test->keys[writer] = g_new0(gchar*, KOTO_TEST_TRACKS_PER_WRITER + 1);
+
+		for (guint i = 0; i < KOTO_TEST_TRACKS_PER_WRITER; i++) {
+			KotoArtist * artist = test->artists[i % KOTO_TEST_ARTISTS];
+			gchar * artist_name = koto_artist_get_name(artist);
+			gchar * track_name = g_strdup_printf("Track %u-%u", writer, i);
+
+			g_ptr_array_add(test->tracks[writer], koto_track_new(koto_artist_get_uuid(artist), NULL, track_name, 0));
+			test->keys[writer][i] = koto_cartographer_build_uniqueish_key(artist_name, NULL, track_name);
+
+			g_free(artist_name);
+			g_free(track_name);
+		}
+	}
+
+	KotoCartographerTestWorker workers[KOTO_TEST_WRITERS + KOTO_TEST_READERS];
+	GThread * threads[KOTO_TEST_WRITERS + KOTO_TEST_READERS];
+	test->writers_running = KOTO_TEST_WRITERS;
+
+	for (guint i = 0; i < KOTO_TEST_WRITERS + KOTO_TEST_READERS; i++) { // Start our readers alongside our writers
+		workers[i].test = test;
+		workers[i].index = (i < KOTO_TEST_WRITERS) ? i : i - KOTO_TEST_WRITERS;
+		threads[i] = g_thread_new((i < KOTO_TEST_WRITERS) ? "cartographer-writer" : "cartographer-reader", (i < KOTO_TEST_WRITERS) ? koto_cartographer_test_writer : koto_cartographer_test_reader, &workers[i]);
+	}
+
+	for (guint i = 0; i < KOTO_TEST_WRITERS + KOTO_TEST_READERS; i++) {
+		g_thread_join(threads[i]);
+	}
+
+	for (guint writer = 0; writer < KOTO_TEST_WRITERS; writer++) { // Every track is now findable both ways
+		for (guint i = 0; i < KOTO_TEST_TRACKS_PER_WRITER; i++) {
+			KotoTrack * track = g_ptr_array_index(test->tracks[writer], i);
+			g_assert_true(koto_cartographer_get_track_by_uuid(koto_maps, koto_track_get_uuid(track)) == track);
+			g_assert_true(koto_cartographer_get_track_by_uniqueish_key(koto_maps, test->keys[writer][i]) == track);
+		}
+	}
+}
+
+int main(
+	int argc,
+	char * argv[]
+) {
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/cartographer/concurrent-inserts-and-lookups", test_cartographer_concurrent_inserts_and_lookups);
+	return g_test_run();
+}
@@ -0,0 +1,215 @@
+/* gapless-test.c
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib-2.0/glib.h>
+#include <glib-2.0/glib/gstdio.h>
+#include <string.h>
+#include <gstreamer-1.0/gst/gst.h>
+
+#define KOTO_TEST_SAMPLE_RATE 44100
+#define KOTO_TEST_SAMPLES_PER_FILE (KOTO_TEST_SAMPLE_RATE / 2)
+#define KOTO_TEST_MAX_GAP GST_MSECOND // Anything beyond rounding at the stream switch is audible silence
+
+typedef struct {
+	GMutex lock;
+	gchar * next_uri; // Queued from about-to-finish, the same way KotoPlaybackEngine queues its next track
+	GstSegment segment; // Segment of the stream currently reaching our sink
+	guint stream_starts;
+	GstClockTime last_end; // Running time where the last buffer of the first stream ended
+	gint64 last_rendered; // Monotonic time the last buffer of the first stream was rendered
+	GstClockTime last_duration;
+	GstClockTime gap; // Running time between the end of the first stream and the start of the second
+	gint64 wall_gap; // Monotonic time between the same two buffers, less the first one's duration
+	gboolean measured;
+} KotoGaplessTest;
+
+static gchar * koto_gapless_test_write_tone(
+	const gchar * dir,
+	const gchar * name,
+	guint period
+) {
+	guint data_size = KOTO_TEST_SAMPLES_PER_FILE * 2; // Mono 16-bit
+	guint8 * wav = g_malloc0(44 + data_size);
+
+	memcpy(wav, "RIFF", 4);
+	GST_WRITE_UINT32_LE(wav + 4, 36 + data_size);
+	memcpy(wav + 8, "WAVEfmt ", 8);
+	GST_WRITE_UINT32_LE(wav + 16, 16); // Size of our fmt chunk
+	GST_WRITE_UINT16_LE(wav + 20, 1); // PCM
+	GST_WRITE_UINT16_LE(wav + 22, 1); // Channels
+	GST_WRITE_UINT32_LE(wav + 24, KOTO_TEST_SAMPLE_RATE);
+	GST_WRITE_UINT32_LE(wav + 28, KOTO_TEST_SAMPLE_RATE * 2); // Bytes per second
+	GST_WRITE_UINT16_LE(wav + 32, 2); // Bytes per frame
+	GST_WRITE_UINT16_LE(wav + 34, 16); // Bits per sample
+	memcpy(wav + 36, "data", 4);
+	GST_WRITE_UINT32_LE(wav + 40, data_size);
+
+	for (guint i = 0; i < KOTO_TEST_SAMPLES_PER_FILE; i++) { // Square wave, so there is no silence of our own making
+		gint16 sample = ((i / period) % 2 == 0) ? 8000 : -8000;
+		GST_WRITE_UINT16_LE(wav + 44 + (i * 2), (guint16) sample);
+	}
+
+	gchar * path = g_build_filename(dir, name, NULL);
+	GError * err = NULL;
+
+	if (!g_file_set_contents(path, (const gchar*) wav, 44 + data_size, &err)) {
+		g_error("Failed to write %s: %s", path, err->message);
+	}
+
+	g_free(wav);
+	return path;
+}
+
+static void koto_gapless_test_handle_about_to_finish(
+	GstElement * playbin,
+	gpointer user_data
+) {
+	KotoGaplessTest * test = user_data;
+
+	g_mutex_lock(&test->lock);
+
+	if (test->next_uri != NULL) { // Have our second file to queue
+		g_object_set(playbin, "uri", test->next_uri, NULL);
+		g_clear_pointer(&test->next_uri, g_free);
+	}
+
+	g_mutex_unlock(&test->lock);
+}
+
+static GstPadProbeReturn koto_gapless_test_handle_sink_event(
+	GstPad * pad,
+	GstPadProbeInfo * info,
+	gpointer user_data
+) {
+	(void) pad;
+	KotoGaplessTest * test = user_data;
+	GstEvent * event = GST_PAD_PROBE_INFO_EVENT(info);
+
+	if (GST_EVENT_TYPE(event) == GST_EVENT_STREAM_START) { // Moved on to a new file
+		test->stream_starts++;
+	} else if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) { // Needed to turn timestamps into running time
+		gst_event_copy_segment(event, &test->segment);
+	}
+
+	return GST_PAD_PROBE_OK;
+}
+
+static void koto_gapless_test_handle_handoff(
+	GstElement * sink,
+	GstBuffer * buffer,
+	GstPad * pad,
+	gpointer user_data
+) {
+	(void) sink;
+	(void) pad;
+	KotoGaplessTest * test = user_data;
+
+	if (!GST_BUFFER_PTS_IS_VALID(buffer)) {
+		return;
+	}
+
+	gint64 rendered = g_get_monotonic_time(); // Handoff happens after syncing to the clock, so this is when the buffer plays
+	GstClockTime start = gst_segment_to_running_time(&test->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+
+	if (test->stream_starts == 1) { // Still in the first file
+		test->last_duration = GST_BUFFER_DURATION_IS_VALID(buffer) ? GST_BUFFER_DURATION(buffer) : 0;
+		test->last_end = start + test->last_duration;
+		test->last_rendered = rendered;
+	} else if ((test->stream_starts == 2) && !test->measured) { // First buffer of the second file
+		test->gap = (start > test->last_end) ? start - test->last_end : 0;
+		test->wall_gap = rendered - test->last_rendered - (gint64) (test->last_duration / GST_USECOND);
+		test->measured = TRUE;
+	}
+}
+
+static void test_gapless_transition() {
+	GstElementFactory * wavparse = gst_element_factory_find("wavparse");
+	GstElement * playbin = gst_element_factory_make("playbin", NULL);
+	GstElement * sink = gst_element_factory_make("fakesink", NULL);
+
+	if ((wavparse == NULL) || (playbin == NULL) || (sink == NULL)) { // Missing plugins, nothing we can measure
+		g_test_skip("Requires playbin, fakesink and wavparse");
+		g_clear_object(&wavparse);
+		g_clear_object(&playbin);
+		g_clear_object(&sink);
+		return;
+	}
+
+	g_object_unref(wavparse);
+
+	gchar * dir = g_dir_make_tmp("koto-gapless-XXXXXX", NULL);
+	g_assert_nonnull(dir);
+
+	gchar * first_path = koto_gapless_test_write_tone(dir, "first.wav", 50);
+	gchar * second_path = koto_gapless_test_write_tone(dir, "second.wav", 80);
+	gchar * first_uri = gst_filename_to_uri(first_path, NULL);
+
+	KotoGaplessTest test = {
+		0
+	};
+
+	g_mutex_init(&test.lock);
+	gst_segment_init(&test.segment, GST_FORMAT_TIME);
+	test.next_uri = gst_filename_to_uri(second_path, NULL);
+	test.last_end = GST_CLOCK_TIME_NONE;
+
+	g_object_set(sink, "sync", TRUE, "signal-handoffs", TRUE, NULL); // Render in real time, like an audio device would
+	g_signal_connect(sink, "handoff", G_CALLBACK(koto_gapless_test_handle_handoff), &test);
+
+	GstPad * sink_pad = gst_element_get_static_pad(sink, "sink");
+	gst_pad_add_probe(sink_pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, koto_gapless_test_handle_sink_event, &test, NULL);
+	gst_object_unref(sink_pad);
+
+	g_object_set(playbin, "audio-sink", sink, "video-sink", gst_element_factory_make("fakesink", NULL), "uri", first_uri, NULL);
+	g_signal_connect(playbin, "about-to-finish", G_CALLBACK(koto_gapless_test_handle_about_to_finish), &test);
+
+	GstBus * bus = gst_element_get_bus(playbin);
+	gst_element_set_state(playbin, GST_STATE_PLAYING);
+
+	GstMessage * msg = gst_bus_timed_pop_filtered(bus, 10 * GST_SECOND, GST_MESSAGE_EOS | GST_MESSAGE_ERROR); // Both files play through to a single end of stream
+	g_assert_nonnull(msg);
+	g_assert_cmpint(GST_MESSAGE_TYPE(msg), ==, GST_MESSAGE_EOS);
+	gst_message_unref(msg);
+
+	gst_element_set_state(playbin, GST_STATE_NULL); // Joins our streaming threads, so the results are safe to read
+	gst_object_unref(bus);
+	gst_object_unref(playbin);
+
+	g_assert_cmpuint(test.stream_starts, ==, 2);
+	g_assert_true(test.measured);
+	g_test_message("Gap at the stream switch: %" GST_TIME_FORMAT " running time, %" G_GINT64_FORMAT " us rendered", GST_TIME_ARGS(test.gap), test.wall_gap);
+	g_assert_cmpuint(test.gap, <=, KOTO_TEST_MAX_GAP);
+
+	g_remove(first_path);
+	g_remove(second_path);
+	g_rmdir(dir);
+	g_free(first_path);
+	g_free(second_path);
+	g_free(first_uri);
+	g_free(dir);
+	g_mutex_clear(&test.lock);
+}
+
+int main(
+	int argc,
+	char * argv[]
+) {
+	gst_init(&argc, &argv);
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/playback/gapless-transition", test_gapless_transition);
+	return g_test_run();
+}
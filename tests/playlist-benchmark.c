@@ -0,0 +1,122 @@
+/* playlist-benchmark.c
+ *
+ * Copyright 2021 Joshua Strobl
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * 	http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <glib-2.0/glib.h>
+#include <gtk-4.0/gtk/gtk.h>
+#include <magic.h>
+#include "../src/db/cartographer.h"
+#include "../src/db/db.h"
+#include "../src/indexer/structs.h"
+#include "../src/playlist/playlist.h"
+
+#define KOTO_BENCHMARK_ARTISTS 50
+#define KOTO_BENCHMARK_TRACKS 20000
+#define KOTO_BENCHMARK_CHANGES 1000
+
+extern KotoCartographer * koto_maps;
+extern sqlite3 * koto_db;
+
+GVolumeMonitor * volume_monitor = NULL; // Normally defined by main.c, which we do not link
+GtkApplication * app = NULL;
+GtkWindow * main_window = NULL;
+magic_t magic_cookie = NULL;
+
+static void koto_benchmark_report(
+	const gchar * name,
+	gint64 started
+) {
+	g_print("%-40s %8.2f ms\n", name, (gdouble) (g_get_monotonic_time() - started) / 1000.0);
+}
+
+int main() {
+	if (sqlite3_open(":memory:", &koto_db) != SQLITE_OK) { // Removing a track from a playlist also removes it from the database
+		g_critical("Failed to open our in-memory database");
+		return 1;
+	}
+
+	create_db_tables(); // Writer is never started, so these and any later writes run directly
+	koto_maps = koto_cartographer_new();
+
+	KotoArtist * artists[KOTO_BENCHMARK_ARTISTS];
+
+	for (guint i = 0; i < KOTO_BENCHMARK_ARTISTS; i++) { // Artists are looked up when sorting by artist
+		gchar * name = g_strdup_printf("Artist %u", g_random_int());
+		artists[i] = koto_artist_new(name);
+		koto_cartographer_add_artist(koto_maps, artists[i]);
+		g_free(name);
+	}
+
+	GPtrArray * tracks = g_ptr_array_new_with_free_func(g_object_unref);
+
+	for (guint i = 0; i < KOTO_BENCHMARK_TRACKS; i++) { // Random names, so sorting by name actually moves tracks around
+		gchar * name = g_strdup_printf("Track %u", g_random_int());
+		g_ptr_array_add(tracks, koto_track_new(koto_artist_get_uuid(artists[i % KOTO_BENCHMARK_ARTISTS]), NULL, name, 0));
+		g_free(name);
+	}
+
+	KotoPlaylist * playlist = koto_playlist_new();
+	gint64 started = g_get_monotonic_time();
+	for (guint i = 0; i < tracks->len; i++) { // One at a time, so this also builds against older trees for a before and after comparison
+		koto_playlist_add_track(playlist, g_ptr_array_index(tracks, i), FALSE, FALSE);
+	}
+
+	koto_playlist_mark_as_finalized(playlist);
+	koto_benchmark_report("add 20k tracks and finalize", started);
+
+	KotoPreferredPlaylistSortType models[] = {
+		KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_TRACK_NAME,
+		KOTO_PREFERRED_PLAYLIST_SORT_TYPE_OLDEST_FIRST,
+		KOTO_PREFERRED_PLAYLIST_SORT_TYPE_SORT_BY_ARTIST,
+		KOTO_PREFERRED_PLAYLIST_SORT_TYPE_DEFAULT,
+	};
+	const gchar * model_names[] = {
+		"sort by track name",
+		"sort oldest first",
+		"sort by artist",
+		"sort newest first",
+	};
+
+	for (guint i = 0; i < G_N_ELEMENTS(models); i++) {
+		started = g_get_monotonic_time();
+		koto_playlist_apply_model(playlist, models[i]);
+		koto_benchmark_report(model_names[i], started);
+	}
+
+	started = g_get_monotonic_time();
+
+	for (guint i = 0; i < tracks->len; i++) { // Look up every position, as views do when binding
+		g_assert(koto_playlist_get_position_of_track(playlist, g_ptr_array_index(tracks, i)) != -1);
+	}
+
+	koto_benchmark_report("position of every track", started);
+
+	started = g_get_monotonic_time();
+
+	for (guint i = 0; i < KOTO_BENCHMARK_CHANGES; i++) { // Remove and re-add, looking up a position after each change as playback does
+		KotoTrack * track = g_ptr_array_index(tracks, g_random_int_range(0, KOTO_BENCHMARK_TRACKS));
+		koto_playlist_remove_track_by_uuid(playlist, koto_track_get_uuid(track));
+		koto_playlist_add_track(playlist, track, FALSE, FALSE);
+		g_assert(koto_playlist_get_position_of_track(playlist, track) != -1);
+	}
+
+	koto_benchmark_report("1k removes and adds", started);
+
+	g_object_unref(playlist);
+	g_ptr_array_unref(tracks);
+	sqlite3_close(koto_db);
+	return 0;
+}